@@ -12,7 +12,7 @@
 #include <boost/asio/system_timer.hpp>
 #include <asio-zmq.hpp>
 
-typedef std::vector<boost::asio::zmq::frame> message_t;
+typedef boost::asio::zmq::message message_t;
 typedef std::shared_ptr<message_t> message_ptr;
 
 static std::string const back_endpoint = "inproc://backend_";
@@ -180,53 +180,27 @@ public:
     }
 };
 
-class thread_pool {
-private:
-    std::vector<std::unique_ptr<std::thread>> pool_;
-    boost::asio::io_service& ios_;
-
-public:
-    thread_pool(boost::asio::io_service& ios, int amount) : pool_(amount - 1), ios_(ios) {}
-
-    ~thread_pool()
-    {
-        for (auto& t : pool_) t->join();
-    }
-
-    void run()
-    {
-        for (auto& t : pool_)
-            t.reset(
-                new std::thread(std::bind(static_cast<std::size_t (boost::asio::io_service::*)()>(
-                                              &boost::asio::io_service::run),
-                                          &ios_)));
-        ios_.run();
-    }
-};
-
 int main()
 {
     std::srand(std::time(0));
 
-    boost::asio::io_service ios;
-    boost::asio::zmq::context ctx;
+    // The broker's two sockets forward to each other, so they share a shard.
+    boost::asio::zmq::runtime rt(thread_amount);
 
-    async_broker broker(ios, ctx);
+    async_broker broker(rt.shard(0), rt.get_context());
     broker.start();
 
     std::vector<std::unique_ptr<client_task>> clients(client_amount);
-    for (int i = 0; i < clients.size(); ++i) {
-        clients[i].reset(new client_task(ios, ctx, i));
+    for (int i = 0; i < client_amount; ++i) {
+        clients[i].reset(new client_task(rt.next_shard(), rt.get_context(), i));
         clients[i]->start();
     }
 
     std::vector<std::unique_ptr<async_worker>> workers(worker_amount);
-    for (int i = 0; i < workers.size(); ++i) {
-        workers[i].reset(new async_worker(ios, ctx, i));
+    for (int i = 0; i < worker_amount; ++i) {
+        workers[i].reset(new async_worker(rt.next_shard(), rt.get_context(), i));
         workers[i]->start();
     }
 
-    // ios.run();
-    thread_pool pool(ios, thread_amount);
-    pool.run();
+    rt.run();
 }
@@ -8,7 +8,6 @@
 #include <functional>
 #include <iostream>
 #include <memory>
-#include <queue>
 #include <string>
 #include <vector>
 #include <boost/asio.hpp>
@@ -113,72 +112,29 @@ public:
 
 class lbbroker {
 private:
-    typedef std::vector<boost::asio::zmq::frame> message_t;
-    typedef std::shared_ptr<message_t> message_ptr;
-
     boost::asio::zmq::socket frontend_;
     boost::asio::zmq::socket backend_;
     //  Logic of LRU loop
-    //  - Poll backend always, frontend only if 1+ worker ready
+    //  - Read backend always, frontend only if 1+ worker ready
     //  - If worker replies, queue worker as ready and forward reply
     //    to client if necessary
     //  - If client requests, pop next worker and send request to it
-    //
-    //  A very simple queue structure with known max size
-    std::queue<std::string> worker_queue_;
+    boost::asio::zmq::lb_broker broker_;
 
-    //  Handle worker activity on backend
-    void handle_worker_ready(boost::system::error_code const& ec, message_ptr buff)
+    void handle_done(boost::system::error_code const& ec)
     {
-        //  Queue worker address for LRU routing
-        worker_queue_.push(std::to_string(buff->front()));
-
-        //  If client reply, send rest back to frontend
-        if (buff->size() == 5)
-            frontend_.async_write_message(
-                std::begin(*buff) + 2, std::end(*buff),
-                std::bind(&lbbroker::null_handler, this, std::placeholders::_1, buff));
-
-        message_ptr frontend_buff{new message_t};
-        frontend_.async_read_message(std::back_inserter(*frontend_buff),
-                                     std::bind(&lbbroker::handle_client_requested, this,
-                                               std::placeholders::_1, frontend_buff));
-
-        message_ptr backend_buff{new message_t};
-        backend_.async_read_message(
-            std::back_inserter(*backend_buff),
-            std::bind(&lbbroker::handle_worker_ready, this, std::placeholders::_1, backend_buff));
+        if (ec) std::cerr << "broker stopped: " << ec.message() << "\n";
     }
 
-    //  Now get next client request, route to LRU worker
-    //  Client request is [address][empty][request]
-    void handle_client_requested(boost::system::error_code const& ec, message_ptr buff)
-    {
-        buff->emplace(std::begin(*buff), boost::asio::zmq::frame(""));
-        buff->emplace(std::begin(*buff), boost::asio::zmq::frame(worker_queue_.front()));
-        worker_queue_.pop();
-        backend_.async_write_message(
-            std::begin(*buff), std::end(*buff),
-            std::bind(&lbbroker::null_handler, this, std::placeholders::_1, buff));
-
-        message_ptr backend_buff{new message_t};
-        backend_.async_read_message(
-            std::back_inserter(*backend_buff),
-            std::bind(&lbbroker::handle_worker_ready, this, std::placeholders::_1, backend_buff));
-    }
-
-    void null_handler(boost::system::error_code const& ec, message_ptr buff) {}
-
 public:
     lbbroker(boost::asio::io_service& ios, boost::asio::zmq::context& ctx)
-        : frontend_(ios, ctx, ZMQ_ROUTER), backend_(ios, ctx, ZMQ_ROUTER), worker_queue_()
+        : frontend_(ios, ctx, ZMQ_ROUTER),
+          backend_(ios, ctx, ZMQ_ROUTER),
+          broker_(frontend_, backend_, worker_count)
     {
         frontend_.bind(front_endpoint);
         backend_.bind(back_endpoint);
-        message_ptr buff{new message_t};
-        backend_.async_read_message(
-            std::back_inserter(*buff),
-            std::bind(&lbbroker::handle_worker_ready, this, std::placeholders::_1, buff));
+        broker_.async_run(std::bind(&lbbroker::handle_done, this, std::placeholders::_1));
     }
 };
 
@@ -1,50 +1,29 @@
 #include <functional>
-#include <iterator>
-#include <memory>
-#include <vector>
+#include <iostream>
 #include <boost/asio.hpp>
 #include <asio-zmq.hpp>
 
 class rrbroker {
 private:
-    typedef std::vector<boost::asio::zmq::frame> message_t;
-    typedef std::shared_ptr<message_t> message_ptr;
-    typedef std::shared_ptr<boost::asio::zmq::socket> socket_ptr;
-
     boost::asio::zmq::socket frontend_;
     boost::asio::zmq::socket backend_;
-    message_t buffer_;
+    boost::asio::zmq::proxy proxy_;
 
 public:
     rrbroker(boost::asio::io_service& ios, boost::asio::zmq::context& ctx)
-        : frontend_(ios, ctx, ZMQ_ROUTER), backend_(ios, ctx, ZMQ_DEALER), buffer_()
+        : frontend_(ios, ctx, ZMQ_ROUTER), backend_(ios, ctx, ZMQ_DEALER),
+          proxy_(frontend_, backend_)
     {
         frontend_.bind("tcp://*:5559");
         backend_.bind("tcp://*:5560");
 
-        frontend_.async_read_message(std::back_inserter(buffer_),
-                                     std::bind(&rrbroker::handle_recv, this, std::placeholders::_1,
-                                               std::ref(frontend_), std::ref(backend_)));
-
-        backend_.async_read_message(std::back_inserter(buffer_),
-                                    std::bind(&rrbroker::handle_recv, this, std::placeholders::_1,
-                                              std::ref(backend_), std::ref(frontend_)));
+        proxy_.async_run(std::bind(&rrbroker::handle_done, this, std::placeholders::_1));
     }
 
-    void handle_recv(boost::system::error_code const& ec, boost::asio::zmq::socket& receiver,
-                     boost::asio::zmq::socket& forwarder)
+    void handle_done(boost::system::error_code const& ec)
     {
-        message_ptr tmp{new message_t};
-        std::swap(*tmp, buffer_);
-        forwarder.async_write_message(
-            tmp->begin(), tmp->end(),
-            std::bind(&rrbroker::null_handler, this, std::placeholders::_1, tmp));
-        receiver.async_read_message(std::back_inserter(buffer_),
-                                    std::bind(&rrbroker::handle_recv, this, std::placeholders::_1,
-                                              std::ref(receiver), std::ref(forwarder)));
+        if (ec) std::cerr << "proxy stopped: " << ec.message() << "\n";
     }
-
-    void null_handler(boost::system::error_code const& ec, message_ptr dummy) {}
 };
 
 int main(int argc, char* argv[])
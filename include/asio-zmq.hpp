@@ -3,4 +3,13 @@
 #include "asio-zmq/exception.hpp"
 #include "asio-zmq/context.hpp"
 #include "asio-zmq/frame.hpp"
+#include "asio-zmq/frame_pool.hpp"
+#include "asio-zmq/message.hpp"
+#include "asio-zmq/monitor.hpp"
+#include "asio-zmq/histogram.hpp"
+#include "asio-zmq/stats.hpp"
+#include "asio-zmq/deadline_service.hpp"
 #include "asio-zmq/socket.hpp"
+#include "asio-zmq/proxy.hpp"
+#include "asio-zmq/lb_broker.hpp"
+#include "asio-zmq/runtime.hpp"
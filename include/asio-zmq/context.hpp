@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cerrno>
 #include <memory>
 #include <zmq.h>
 #include "helpers.hpp"
@@ -17,9 +18,11 @@ private:
 
     int get_option(int option)
     {
+        // Some options, such as ZMQ_THREAD_SCHED_POLICY, legitimately read as -1.
+        errno = 0;
         int ret = zmq_ctx_get(zctx_.get(), option);
 
-        if (ret < 0) throw exception();
+        if (ret == -1 && errno != 0) throw exception();
 
         return ret;
     }
@@ -47,6 +50,50 @@ public:
     void set_io_threads(int num) { set_option(ZMQ_IO_THREADS, num); }
 
     void set_max_sockets(int num) { set_option(ZMQ_MAX_SOCKETS, num); }
+
+    // The accessors below exist only when the zmq.h in use defines the option. Options that
+    // shape ZeroMQ's I/O threads take effect when the threads start, i.e. they must be set
+    // before the first socket is created.
+
+#ifdef ZMQ_BLOCKY
+    bool get_blocky() { return get_option(ZMQ_BLOCKY) != 0; }
+
+    void set_blocky(bool blocky) { set_option(ZMQ_BLOCKY, blocky ? 1 : 0); }
+#endif
+
+#ifdef ZMQ_MAX_MSGSZ
+    int get_max_msgsz() { return get_option(ZMQ_MAX_MSGSZ); }
+
+    void set_max_msgsz(int size) { set_option(ZMQ_MAX_MSGSZ, size); }
+#endif
+
+#ifdef ZMQ_MSG_T_SIZE
+    int get_msg_t_size() { return get_option(ZMQ_MSG_T_SIZE); }
+#endif
+
+#ifdef ZMQ_THREAD_AFFINITY_CPU_ADD
+    // Adds cpu to the set ZeroMQ's I/O threads are allowed to run on; the set starts empty,
+    // which means any cpu.
+    void add_thread_affinity_cpu(int cpu) { set_option(ZMQ_THREAD_AFFINITY_CPU_ADD, cpu); }
+
+    void remove_thread_affinity_cpu(int cpu) { set_option(ZMQ_THREAD_AFFINITY_CPU_REMOVE, cpu); }
+#endif
+
+#ifdef ZMQ_THREAD_SCHED_POLICY
+    int get_thread_sched_policy() { return get_option(ZMQ_THREAD_SCHED_POLICY); }
+
+    void set_thread_sched_policy(int policy) { set_option(ZMQ_THREAD_SCHED_POLICY, policy); }
+#endif
+
+#ifdef ZMQ_THREAD_PRIORITY
+    void set_thread_priority(int priority) { set_option(ZMQ_THREAD_PRIORITY, priority); }
+#endif
+
+#ifdef ZMQ_THREAD_NAME_PREFIX
+    int get_thread_name_prefix() { return get_option(ZMQ_THREAD_NAME_PREFIX); }
+
+    void set_thread_name_prefix(int prefix) { set_option(ZMQ_THREAD_NAME_PREFIX, prefix); }
+#endif
 };
 
 }  // namespace zmq
@@ -0,0 +1,429 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <boost/version.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#if BOOST_VERSION >= 106600
+#include <boost/asio/bind_executor.hpp>
+#endif
+#include <boost/system/error_code.hpp>
+#include <asio-zmq/helpers.hpp>
+
+namespace boost {
+namespace asio {
+namespace zmq {
+
+class deadline_service;
+
+namespace detail {
+
+class deadline_expiry;
+
+// An operation's place in a timer_wheel. Like write_op it dispatches through function pointers
+// so that the concrete operation decides where its expiry runs and what expiring means: submit
+// hands the deadline_expiry of a due entry to the executor the operation completes on, and expire
+// is called when that runs, unless the entry was cancelled in between.
+class deadline_entry {
+public:
+    typedef void (*submit_func)(deadline_entry*, deadline_expiry&&);
+    typedef void (*expire_func)(deadline_entry*);
+
+    bool scheduled() const { return list_ != nullptr; }
+
+protected:
+    deadline_entry(submit_func submit, expire_func expire)
+        : list_(nullptr),
+          prev_(nullptr),
+          next_(nullptr),
+          tick_(0),
+          serial_(0),
+          submit_(submit),
+          expire_(expire)
+    {
+    }
+
+    ~deadline_entry() {}
+
+private:
+    friend class timer_wheel;
+    friend class zmq::deadline_service;
+
+    deadline_entry** list_;
+    deadline_entry* prev_;
+    deadline_entry* next_;
+    std::uint64_t tick_;
+    // Tells an expiry of this entry from one submitted for an earlier use of its memory.
+    std::uint64_t serial_;
+    submit_func submit_;
+    expire_func expire_;
+};
+
+// Hashed timer wheel. Deadlines are counted in ticks and hashed by tick into a fixed ring of
+// slots, each an intrusive list, so that scheduling and cancelling are O(1) however many
+// deadlines are pending. A slot holds the entries of every tick congruent to it; those due in a
+// later revolution stay where they are until their tick comes round. The wheel does no locking of
+// its own.
+class timer_wheel {
+public:
+    static std::size_t const slot_count = 512;
+
+private:
+    std::array<deadline_entry*, slot_count> slots_;
+    // Entries taken off the wheel by advance and not yet handed out by take_due.
+    deadline_entry* due_;
+    // Entries handed out by take_due whose expiry has not yet claimed them, oldest first, so
+    // that expiries claiming them in the order they were submitted find them at the front.
+    deadline_entry* expiring_;
+    deadline_entry* expiring_back_;
+    // The last tick whose entries have been taken off the wheel.
+    std::uint64_t tick_;
+    std::uint64_t serial_;
+    // The entries in slots_ and due_.
+    std::size_t size_;
+
+    void link(deadline_entry& e, deadline_entry*& list)
+    {
+        e.list_ = &list;
+        e.prev_ = nullptr;
+        e.next_ = list;
+        if (list != nullptr) list->prev_ = &e;
+        list = &e;
+        ++size_;
+    }
+
+public:
+    timer_wheel()
+        : slots_(),
+          due_(nullptr),
+          expiring_(nullptr),
+          expiring_back_(nullptr),
+          tick_(0),
+          serial_(0),
+          size_(0)
+    {
+        slots_.fill(nullptr);
+    }
+
+    timer_wheel(timer_wheel const&) = delete;
+    timer_wheel& operator=(timer_wheel const&) = delete;
+
+    ~timer_wheel() { clear(); }
+
+    // Whether no entry is waiting for its tick; entries being expired do not count.
+    bool empty() const { return size_ == 0; }
+
+    std::size_t size() const { return size_; }
+
+    // Schedules e to expire at tick, or at the next tick if that one has already passed.
+    // Returns the tick it was scheduled for.
+    std::uint64_t schedule(deadline_entry& e, std::uint64_t tick)
+    {
+        if (tick <= tick_) tick = tick_ + 1;
+        e.tick_ = tick;
+        link(e, slots_[tick % slot_count]);
+        return tick;
+    }
+
+    // Does nothing if e is not scheduled.
+    void cancel(deadline_entry& e)
+    {
+        if (!e.scheduled()) return;
+        if (e.prev_ != nullptr)
+            e.prev_->next_ = e.next_;
+        else
+            *e.list_ = e.next_;
+        if (e.next_ != nullptr)
+            e.next_->prev_ = e.prev_;
+        else if (e.list_ == &expiring_)
+            expiring_back_ = e.prev_;
+        if (e.list_ != &expiring_) --size_;
+        e.list_ = nullptr;
+        e.prev_ = nullptr;
+        e.next_ = nullptr;
+    }
+
+    // Moves every entry due by tick to the list of due entries, from which take_due hands them
+    // out one by one. A due entry counts as scheduled until then, and may still be cancelled.
+    void advance(std::uint64_t tick)
+    {
+        if (tick <= tick_) return;
+
+        std::uint64_t span = tick - tick_ < slot_count ? tick - tick_ : slot_count;
+        for (std::uint64_t t = tick_ + 1; t <= tick_ + span; ++t) {
+            deadline_entry* e = slots_[t % slot_count];
+            while (e != nullptr) {
+                deadline_entry* next = e->next_;
+                if (e->tick_ <= tick) {
+                    cancel(*e);
+                    link(*e, due_);
+                }
+                e = next;
+            }
+        }
+        tick_ = tick;
+    }
+
+    // Moves a due entry to the list of entries being expired and returns it, or nullptr if there
+    // is none. It counts as scheduled, and may still be cancelled, until claim takes it off.
+    deadline_entry* take_due()
+    {
+        deadline_entry* e = due_;
+        if (e != nullptr) {
+            cancel(*e);
+            e->serial_ = ++serial_;
+            e->list_ = &expiring_;
+            e->prev_ = expiring_back_;
+            if (expiring_back_ != nullptr)
+                expiring_back_->next_ = e;
+            else
+                expiring_ = e;
+            expiring_back_ = e;
+        }
+        return e;
+    }
+
+    // Unschedules e if it is still being expired under serial, which it was given by take_due.
+    // Only the entries on the list are looked at, as e may since have been cancelled and freed.
+    bool claim(deadline_entry* e, std::uint64_t serial)
+    {
+        for (deadline_entry* p = expiring_; p != nullptr; p = p->next_) {
+            if (p == e && p->serial_ == serial) {
+                cancel(*p);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void expire(deadline_entry* e) { e->expire_(e); }
+
+    // The first tick after the current one whose slot holds entries; only meaningful when the
+    // wheel is not empty. The entries found there may belong to a later revolution.
+    std::uint64_t next_tick() const
+    {
+        for (std::uint64_t t = tick_ + 1; t < tick_ + slot_count; ++t)
+            if (slots_[t % slot_count] != nullptr) return t;
+        return tick_ + slot_count;
+    }
+
+    // Unschedules every entry without expiring it.
+    void clear()
+    {
+        for (auto& slot : slots_)
+            while (slot != nullptr) cancel(*slot);
+        while (due_ != nullptr) cancel(*due_);
+        while (expiring_ != nullptr) cancel(*expiring_);
+    }
+};
+
+// Gives Service the static id that use_service looks for while keeping it header-only.
+template <typename Service> class service_base : public io_service::service {
+public:
+    static io_service::id id;
+
+    explicit service_base(io_service& io) : io_service::service(io) {}
+};
+
+template <typename Service> io_service::id service_base<Service>::id;
+
+// The expiry of a due entry, as a handler. It holds the entry only by address, as the operation
+// may finish, and free the entry, before it runs.
+class deadline_expiry {
+private:
+    deadline_service* service_;
+    deadline_entry* entry_;
+    std::uint64_t serial_;
+
+public:
+    deadline_expiry(deadline_service& service, deadline_entry& entry, std::uint64_t serial)
+        : service_(&service), entry_(&entry), serial_(serial)
+    {
+    }
+
+    // Posts the expiry to the executor associated with handler, where the operation it belongs
+    // to runs and completes.
+    template <typename Handler> void submit(Handler const& handler) &&;
+
+    void operator()();
+};
+
+}  // namespace detail
+
+// The deadlines of the asynchronous operations of every socket on one io_service, kept in a
+// timer_wheel driven by a single steady_timer. A deadline expires at the first tick at or after
+// it, so operations time out up to one tick late but never early.
+//
+// The timer is set for the next slot that holds deadlines, but never more than max_horizon
+// ticks ahead. Cancelling the last pending deadline leaves it to run out rather than cancelling
+// it, which in a loop of reads that each finish before their deadline would cost two timer
+// operations per read; an io_service whose deadlines are all gone therefore runs out of work
+// within max_horizon ticks.
+//
+// Sockets on different threads of one io_service may share the service: the wheel and the timer
+// are guarded by a mutex, and the timer's handler runs on a strand, so that one tick hands out
+// its deadlines before the next begins. A tick only submits each expiry to the executor of the
+// operation it belongs to, which runs it there after claiming the entry under the mutex: an
+// operation that completes first, on another thread, cancels its deadline as it does, and the
+// expiry then finds nothing to claim and does nothing.
+class deadline_service : public detail::service_base<deadline_service> {
+public:
+    typedef std::chrono::steady_clock clock_type;
+    typedef clock_type::time_point time_point;
+    typedef std::chrono::milliseconds duration;
+
+    static std::uint64_t const max_horizon = 64;
+
+    static duration tick_duration() { return duration(1); }
+
+private:
+    class timer_handler {
+    private:
+        deadline_service* service_;
+
+    public:
+        explicit timer_handler(deadline_service& service) : service_(&service) {}
+
+        void operator()(boost::system::error_code const& ec) { service_->handle_timer(ec); }
+    };
+
+    io_service& io_;
+    mutable std::mutex mutex_;
+    detail::timer_wheel wheel_;
+#if BOOST_VERSION >= 106600
+    boost::asio::strand<io_service::executor_type> strand_;
+#else
+    io_service::strand strand_;
+#endif
+    boost::asio::steady_timer timer_;
+    time_point origin_;
+    // The tick the timer is set for; 0 when it is not set.
+    std::uint64_t armed_;
+
+    // The tick at or after t.
+    std::uint64_t tick_of(time_point t) const
+    {
+        if (t <= origin_) return 0;
+        auto ticks = (t - origin_ + tick_duration() - clock_type::duration(1)) / tick_duration();
+        return static_cast<std::uint64_t>(ticks);
+    }
+
+    // The tick at or before now.
+    std::uint64_t current_tick() const
+    {
+        return static_cast<std::uint64_t>((clock_type::now() - origin_) / tick_duration());
+    }
+
+    // Called with the mutex held.
+    void arm(std::uint64_t tick)
+    {
+        if (armed_ != 0 && armed_ <= tick) return;
+        std::uint64_t horizon = current_tick() + max_horizon;
+        armed_ = tick < horizon ? tick : horizon;
+        timer_.expires_at(origin_ + static_cast<duration::rep>(armed_) * tick_duration());
+#if BOOST_VERSION >= 106600
+        timer_.async_wait(boost::asio::bind_executor(strand_, timer_handler(*this)));
+#else
+        timer_.async_wait(strand_.wrap(timer_handler(*this)));
+#endif
+    }
+
+    void handle_timer(boost::system::error_code const& ec)
+    {
+        // An aborted wait was superseded by one for an earlier deadline.
+        if (ec) return;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        armed_ = 0;
+        wheel_.advance(current_tick());
+        // Submitting posts, so no expiry runs while the mutex is held.
+        while (detail::deadline_entry* e = wheel_.take_due())
+            e->submit_(e, detail::deadline_expiry(*this, *e, e->serial_));
+        if (!wheel_.empty()) arm(wheel_.next_tick());
+    }
+
+    friend class detail::deadline_expiry;
+
+    void expire(detail::deadline_entry* e, std::uint64_t serial)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!wheel_.claim(e, serial)) return;
+        }
+        detail::timer_wheel::expire(e);
+    }
+
+#if BOOST_VERSION >= 106600
+    void shutdown() override
+#else
+    void shutdown_service() override
+#endif
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wheel_.clear();
+    }
+
+public:
+    explicit deadline_service(io_service& io)
+        : detail::service_base<deadline_service>(io),
+          io_(io),
+          mutex_(),
+          wheel_(),
+#if BOOST_VERSION >= 106600
+          strand_(io.get_executor()),
+#else
+          strand_(io),
+#endif
+          timer_(io),
+          origin_(clock_type::now()),
+          armed_(0)
+    {
+    }
+
+    // e must stay alive, and must not be scheduled again, until it expires or is cancelled.
+    void schedule(detail::deadline_entry& e, time_point deadline)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        arm(wheel_.schedule(e, tick_of(deadline)));
+    }
+
+    void cancel(detail::deadline_entry& e)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wheel_.cancel(e);
+    }
+
+    // The deadlines waiting for their tick.
+    std::size_t pending() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return wheel_.size();
+    }
+};
+
+namespace detail {
+
+template <typename Handler> void deadline_expiry::submit(Handler const& handler) &&
+{
+    io_service& io = service_->io_;
+#if BOOST_VERSION >= 106600
+    detail::post(io, boost::asio::bind_executor(
+                         boost::asio::get_associated_executor(handler, io.get_executor()),
+                         std::move(*this)));
+#else
+    io.post(std::move(*this));
+#endif
+}
+
+inline void deadline_expiry::operator()() { service_->expire(entry_, serial_); }
+
+}  // namespace detail
+
+}  // namespace zmq
+}  // namespace asio
+}  // namespace boost
@@ -0,0 +1,290 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <boost/asio/error.hpp>
+#include <boost/system/error_code.hpp>
+#include "helpers.hpp"
+#include "exception.hpp"
+#include "handler_memory.hpp"
+#include "socket.hpp"
+#include "socket_option.hpp"
+
+namespace boost {
+namespace asio {
+namespace zmq {
+namespace detail {
+
+// Type-erased holder for the handler passed to a device's async_run, which keeps work on the
+// handler's executor for as long as the device runs.
+class device_completion {
+public:
+    typedef void (*complete_func)(device_completion*, boost::system::error_code const*);
+
+    // Destroys the holder and then completes its handler with ec.
+    void complete(boost::system::error_code const& ec) { complete_(this, &ec); }
+
+    // Destroys the holder without invoking its handler.
+    void destroy() { complete_(this, nullptr); }
+
+protected:
+    explicit device_completion(complete_func complete) : complete_(complete) {}
+
+    ~device_completion() {}
+
+private:
+    complete_func complete_;
+};
+
+template <typename Handler> class device_completion_impl : public device_completion {
+private:
+    socket* sock_;
+    Handler handler_;
+    handler_work<Handler> work_;
+
+    static void do_complete(device_completion* base, boost::system::error_code const* ec)
+    {
+        device_completion_impl* self = static_cast<device_completion_impl*>(base);
+        socket* sock = self->sock_;
+        Handler handler(std::move(self->handler_));
+        handler_work<Handler> work(std::move(self->work_));
+        delete self;
+        if (ec != nullptr) sock->complete(std::move(handler), *ec);
+    }
+
+public:
+    device_completion_impl(socket& sock, Handler&& handler)
+        : device_completion(&device_completion_impl::do_complete),
+          sock_(&sock),
+          handler_(std::move(handler)),
+          work_(handler_, sock.io_)
+    {
+    }
+};
+
+// Event loop shared by the devices that shuttle messages between sockets. Derived implements
+//
+//     bool step();   // moves whatever can move without blocking; returns whether anything did
+//     bool ready();  // reads ZMQ_EVENTS of the sockets it waits for, which rearms their ZMQ_FD
+//
+// and the loop calls step() until neither reports progress, then waits for any of the
+// SocketCount sockets (null entries are skipped) to signal. Derived may also implement
+//
+//     bool waits_on(std::size_t index);  // whether a signal from the socket could let it move
+//
+// to leave out a socket whose signals would only wake the loop for nothing; by default every
+// socket is waited for.
+template <typename Derived, std::size_t SocketCount> class basic_device {
+private:
+    using error_code = boost::system::error_code;
+
+    // Waits for one socket's ZMQ_FD to signal. Its memory comes from that socket.
+    class wait_handler {
+    private:
+        basic_device* device_;
+        std::size_t index_;
+        handler_memory* memory_;
+
+    public:
+        typedef recycling_allocator<void> allocator_type;
+
+        wait_handler(basic_device& device, std::size_t index, handler_memory& memory)
+            : device_(&device), index_(index), memory_(&memory)
+        {
+        }
+
+        allocator_type get_allocator() const noexcept { return allocator_type(*memory_); }
+
+        void operator()(error_code const& ec, std::size_t = 0)
+        {
+            device_->handle_wait(index_, ec);
+        }
+
+        friend void* asio_handler_allocate(std::size_t size, wait_handler* self)
+        {
+            return self->memory_->allocate(size);
+        }
+
+        friend void asio_handler_deallocate(void* p, std::size_t, wait_handler*)
+        {
+            handler_memory::deallocate(p);
+        }
+    };
+
+    struct run_initiation {
+        basic_device* device_;
+
+        template <typename Handler> void operator()(Handler&& handler) const
+        {
+            device_->start(std::forward<Handler>(handler));
+        }
+    };
+
+    std::array<bool, SocketCount> waiting_;
+    device_completion* completion_;
+    error_code result_;
+    bool terminated_;
+    bool running_;
+
+    Derived& derived() { return static_cast<Derived&>(*this); }
+
+    void pump()
+    {
+        try {
+            for (;;) {
+                bool progress = derived().step();
+                if (terminated_ || (!progress && !derived().ready())) break;
+            }
+        }
+        catch (exception const& e) {
+            if (!result_) result_ = e.get_code();
+            terminate();
+        }
+
+        if (!terminated_) {
+            for (std::size_t i = 0; i < SocketCount; ++i)
+                if (derived().waits_on(i)) arm(i);
+        }
+        finish_if_idle();
+    }
+
+    void arm(std::size_t index)
+    {
+        socket* sock = sockets_[index];
+        if (sock == nullptr || waiting_[index]) return;
+        waiting_[index] = true;
+        sock->descriptor_.async_read_some(null_buffers(),
+                                          wait_handler(*this, index, sock->memory_));
+    }
+
+    void handle_wait(std::size_t index, error_code const& ec)
+    {
+        waiting_[index] = false;
+        if (!ec) sockets_[index]->stats_.wakeup();
+        if (ec && ec != boost::asio::error::operation_aborted && !result_) {
+            result_ = ec;
+            terminate();
+        }
+        if (terminated_)
+            finish_if_idle();
+        else
+            pump();
+    }
+
+    // Completes the run once every wait has returned, so that nothing refers to the device
+    // after its handler may have destroyed it.
+    void finish_if_idle()
+    {
+        if (!running_ || !terminated_) return;
+        for (bool w : waiting_)
+            if (w) return;
+
+        running_ = false;
+        device_completion* c = completion_;
+        completion_ = nullptr;
+        c->complete(result_);
+    }
+
+    template <typename Handler> void start(Handler&& handler)
+    {
+        typedef typename std::decay<Handler>::type handler_type;
+
+        if (running_) {
+            sockets_[0]->complete(handler_type(std::forward<Handler>(handler)),
+                                  error_code(boost::asio::error::in_progress));
+            return;
+        }
+
+        completion_ = new device_completion_impl<handler_type>(
+            *sockets_[0], handler_type(std::forward<Handler>(handler)));
+        running_ = true;
+        terminated_ = false;
+        result_ = error_code();
+        pump();
+    }
+
+protected:
+    // The first socket is mandatory; the handler of async_run completes through it.
+    std::array<socket*, SocketCount> sockets_;
+
+    basic_device()
+        : waiting_(), completion_(nullptr), result_(), terminated_(false), running_(false),
+          sockets_()
+    {
+        waiting_.fill(false);
+        sockets_.fill(nullptr);
+    }
+
+    ~basic_device()
+    {
+        if (completion_ != nullptr) completion_->destroy();
+    }
+
+    bool terminated() const { return terminated_; }
+
+    bool waits_on(std::size_t) const { return true; }
+
+    static int type_of(socket& sock)
+    {
+        socket_option::socket_type type;
+        sock.get_option(type);
+        return type.value();
+    }
+
+public:
+    basic_device(basic_device const&) = delete;
+    basic_device& operator=(basic_device const&) = delete;
+
+    // Runs until terminate(), then completes with no error, or until a socket fails, then
+    // completes with its error. The handler signature is void(error_code const&).
+    template <typename RunToken>
+    initfn_result_t<RunToken, void(error_code)> async_run(RunToken&& token)
+    {
+        return async_initiate<RunToken, void(error_code)>(run_initiation{this}, token);
+    }
+
+    bool running() const { return running_; }
+
+    // Stops the device and cancels its waits. Cancelling also cancels any other operations
+    // pending on the same sockets.
+    void terminate()
+    {
+        if (terminated_) return;
+        terminated_ = true;
+        for (std::size_t i = 0; i < SocketCount; ++i) {
+            if (sockets_[i] != nullptr && waiting_[i]) sockets_[i]->cancel();
+        }
+    }
+};
+
+// Keeps a device started by one of the async_ free functions alive until its handler has run.
+template <typename Device, typename Handler> class device_owner_handler {
+private:
+    std::unique_ptr<Device> device_;
+    Handler handler_;
+
+public:
+    device_owner_handler(std::unique_ptr<Device>&& device, Handler&& handler)
+        : device_(std::move(device)), handler_(std::move(handler))
+    {
+    }
+
+    void operator()(boost::system::error_code const& ec) { handler_(ec); }
+};
+
+template <typename Device, typename Handler>
+void run_owned_device(std::unique_ptr<Device>&& device, Handler&& handler)
+{
+    typedef typename std::decay<Handler>::type handler_type;
+    Device* raw = device.get();
+    raw->async_run(device_owner_handler<Device, handler_type>(
+        std::move(device), handler_type(std::forward<Handler>(handler))));
+}
+
+}  // namespace detail
+}  // namespace zmq
+}  // namespace asio
+}  // namespace boost
@@ -19,13 +19,13 @@ struct zmq_error_category_impl : public system::error_category {
     virtual std::string message(int ev) const noexcept { return ::zmq_strerror(ev); }
 };
 
-const system::error_category& zmq_category()
+inline const system::error_category& zmq_category()
 {
     static zmq_error_category_impl instance;
     return instance;
 }
 
-system::error_code make_error_code(zmq_error e)
+inline system::error_code make_error_code(zmq_error e)
 {
     return system::error_code(static_cast<int>(e), zmq_category());
 }
@@ -1,11 +1,14 @@
 #pragma once
 
 #include <algorithm>
+#include <cerrno>
 #include <cstddef>
 #include <iterator>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <utility>
+#include <vector>
 #include <zmq.h>
 #include "helpers.hpp"
 #include "exception.hpp"
@@ -16,10 +19,51 @@ namespace zmq {
 
 class frame {
     friend class socket;
+    friend class frame_pool;
 
 private:
     zmq_msg_t raw_msg_;
 
+    // Payloads up to this size are copied: ZeroMQ stores them inline in the zmq_msg_t, which
+    // is cheaper than keeping a heap-allocated owner alive.
+    static std::size_t const copy_threshold = 32;
+
+    template <typename Owner> static void delete_owner(void*, void* hint)
+    {
+        delete static_cast<Owner*>(hint);
+    }
+
+    template <typename T> static void delete_array(void* data, void*)
+    {
+        delete[] static_cast<T*>(data);
+    }
+
+    // Hands data to ZeroMQ without copying; release(data, hint) runs once the last reference
+    // to the message is gone, possibly on one of ZeroMQ's I/O threads.
+    void init_data(void const* data, std::size_t size, zmq_free_fn* release, void* hint)
+    {
+        if (0 != zmq_msg_init_data(&raw_msg_, const_cast<void*>(data), size, release, hint)) {
+            int err = zmq_errno();
+            zmq_msg_init(&raw_msg_);
+            release(const_cast<void*>(data), hint);
+            errno = err;
+            throw exception();
+        }
+    }
+
+    template <typename Container> void init_moved(Container&& buff)
+    {
+        std::size_t size = buff.size() * sizeof(typename Container::value_type);
+        if (size <= copy_threshold) {
+            if (0 != zmq_msg_init_size(&raw_msg_, size)) throw exception();
+            std::copy(std::begin(buff), std::end(buff),
+                      static_cast<typename Container::value_type*>(data()));
+        } else {
+            Container* owner = new Container(std::move(buff));
+            init_data(&(*owner)[0], size, &delete_owner<Container>, owner);
+        }
+    }
+
 public:
     explicit frame(std::size_t size) : raw_msg_()
     {
@@ -38,7 +82,8 @@ public:
         return *this;
     }
 
-    frame(frame const& other) : frame(other.size())
+    // Shares the payload with other instead of copying it.
+    frame(frame const& other) : frame()
     {
         if (0 != zmq_msg_copy(&raw_msg_, const_cast<zmq_msg_t*>(&other.raw_msg_)))
             throw exception();
@@ -49,6 +94,43 @@ public:
         std::copy(std::begin(str), std::end(str), static_cast<char*>(data()));
     }
 
+    // Takes over the string's buffer instead of copying it.
+    explicit frame(std::string&& str) : raw_msg_() { init_moved(std::move(str)); }
+
+    // Takes over the vector's buffer instead of copying it.
+    template <typename T> explicit frame(std::vector<T>&& buff) : raw_msg_()
+    {
+        static_assert(std::is_trivially_copyable<T>::value && std::is_standard_layout<T>::value,
+                      "frame payload must be trivially copyable with standard layout");
+        init_moved(std::move(buff));
+    }
+
+    // Takes ownership of count elements; the array is released with delete[].
+    template <typename T> frame(std::unique_ptr<T[]>&& buff, std::size_t count) : raw_msg_()
+    {
+        static_assert(std::is_trivially_copyable<T>::value && std::is_standard_layout<T>::value,
+                      "frame payload must be trivially copyable with standard layout");
+        if (count == 0) {
+            zmq_msg_init(&raw_msg_);
+            return;
+        }
+        init_data(buff.release(), count * sizeof(T), &delete_array<T>, nullptr);
+    }
+
+    // Shares size bytes at owner.get() with ZeroMQ, keeping owner alive until ZeroMQ releases
+    // the payload. The caller must not modify the bytes while the frame or a copy is in flight.
+    static frame from_shared(std::shared_ptr<void const> owner, std::size_t size)
+    {
+        frame tmp;
+        if (size == 0) return tmp;
+
+        typedef std::shared_ptr<void const> owner_type;
+        void const* payload = owner.get();
+        zmq_msg_close(&tmp.raw_msg_);
+        tmp.init_data(payload, size, &delete_owner<owner_type>, new owner_type(std::move(owner)));
+        return tmp;
+    }
+
     frame& operator=(frame const& other)
     {
         frame tmp(other);
@@ -58,6 +140,9 @@ public:
 
     std::size_t size() const noexcept { return zmq_msg_size(const_cast<zmq_msg_t*>(&raw_msg_)); }
 
+    // True when this frame was received as a non-final part of a multipart message.
+    bool more() const noexcept { return 0 != zmq_msg_more(const_cast<zmq_msg_t*>(&raw_msg_)); }
+
     void* data() noexcept { return zmq_msg_data(&raw_msg_); }
 
     const void* data() const noexcept { return zmq_msg_data(const_cast<zmq_msg_t*>(&raw_msg_)); }
@@ -69,7 +154,7 @@ public:
 
 namespace std {
 
-std::string to_string(boost::asio::zmq::frame const& frame)
+inline std::string to_string(boost::asio::zmq::frame const& frame)
 {
     return std::string(static_cast<char const*>(frame.data()), frame.size());
 }
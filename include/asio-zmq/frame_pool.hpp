@@ -0,0 +1,302 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <vector>
+#include <sys/mman.h>
+#include <zmq.h>
+#include "frame.hpp"
+
+namespace boost {
+namespace asio {
+namespace zmq {
+
+struct frame_pool_stats {
+    std::uint64_t hits;      // payloads served from a cached buffer
+    std::uint64_t misses;    // payloads that needed a new slab to be carved
+    std::uint64_t oversize;  // payloads above max_size, served straight from the heap
+    std::uint64_t releases;  // payloads returned by ZeroMQ
+};
+
+// Hands out frame payloads from power-of-two size classes between 64 bytes and max_size.
+// Buffers are carved from slabs that live as long as the pool and are returned to it by
+// ZeroMQ's free callback, so a steady flow of frames of similar sizes stops allocating once
+// the slabs are warm. Threads are spread over a fixed set of cache stripes, so that unless
+// more than 16 threads use the pool each has a cache of free buffers to itself; caches overflow
+// into, and refill from, a shared list per size class.
+//
+// The pool must outlive every frame it produced, including copies still queued in ZeroMQ.
+class frame_pool {
+private:
+    static std::size_t const min_shift = 6;
+    static std::size_t const class_count = 24;
+    static std::size_t const cache_count = 16;
+    static std::size_t const cache_limit = 64;
+    static std::size_t const slab_size = std::size_t(2) << 20;
+    static std::uint32_t const oversize_class = ~std::uint32_t(0);
+
+    union header {
+        struct {
+            frame_pool* pool;
+            std::uint32_t size_class;
+        } owner;
+        std::max_align_t align;
+    };
+
+    // Caches are nearly always touched by a single thread, so a spin lock is cheaper than a
+    // mutex here.
+    struct spin_mutex {
+        std::atomic_flag flag;
+        spin_mutex() { flag.clear(); }
+        void lock()
+        {
+            while (flag.test_and_set(std::memory_order_acquire)) {
+            }
+        }
+        void unlock() { flag.clear(std::memory_order_release); }
+    };
+
+    struct free_list {
+        std::vector<header*> blocks;
+        spin_mutex mutex;
+    };
+
+    struct slab {
+        void* base;
+        std::size_t size;
+        bool mapped;
+    };
+
+    std::size_t max_size_;
+    std::size_t max_class_;
+    bool hugepages_;
+
+    std::array<free_list, class_count> shared_;
+    std::array<std::array<free_list, class_count>, cache_count> caches_;
+
+    std::mutex slab_mutex_;
+    std::vector<slab> slabs_;
+
+    std::atomic<std::uint64_t> hits_;
+    std::atomic<std::uint64_t> misses_;
+    std::atomic<std::uint64_t> oversize_;
+    std::atomic<std::uint64_t> releases_;
+
+    static std::size_t class_of(std::size_t size)
+    {
+        std::size_t c = 0;
+        while ((std::size_t(1) << (c + min_shift)) < size) ++c;
+        return c;
+    }
+
+    static std::size_t block_size(std::size_t size_class)
+    {
+        return sizeof(header) + (std::size_t(1) << (size_class + min_shift));
+    }
+
+    static std::size_t thread_index()
+    {
+        static std::atomic<std::size_t> next(0);
+        static thread_local std::size_t index = next.fetch_add(1) % cache_count;
+        return index;
+    }
+
+    // The default huge page size, which MAP_HUGETLB mappings must be a multiple of.
+    static std::size_t huge_page_size()
+    {
+        static std::size_t const size = [] {
+            std::size_t kb = 0;
+            if (std::FILE* f = std::fopen("/proc/meminfo", "r")) {
+                char line[128];
+                while (std::fgets(line, sizeof line, f))
+                    if (std::sscanf(line, "Hugepagesize: %zu kB", &kb) == 1) break;
+                std::fclose(f);
+            }
+            return kb != 0 ? kb << 10 : std::size_t(2) << 20;
+        }();
+        return size;
+    }
+
+    // Returns at least size bytes, updating size if the mapping had to be made longer.
+    void* map_slab(std::size_t& size, bool& mapped)
+    {
+        mapped = false;
+        if (hugepages_) {
+#ifdef MAP_HUGETLB
+            std::size_t page = huge_page_size();
+            std::size_t rounded = (size + page - 1) / page * page;
+            void* p = ::mmap(nullptr, rounded, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED) {
+                size = rounded;
+                mapped = true;
+                return p;
+            }
+#endif
+            // No reserved huge pages: fall back to transparent huge pages where available.
+            void* q = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                             -1, 0);
+            if (q != MAP_FAILED) {
+#ifdef MADV_HUGEPAGE
+                ::madvise(q, size, MADV_HUGEPAGE);
+#endif
+                mapped = true;
+                return q;
+            }
+        }
+        return ::operator new(size);
+    }
+
+    // Carves a new slab for size_class into the shared list and returns one block of it.
+    header* grow(std::size_t size_class)
+    {
+        std::size_t block = block_size(size_class);
+        std::size_t size = block > slab_size ? block : slab_size - slab_size % block;
+
+        slab s;
+        s.base = map_slab(size, s.mapped);
+        s.size = size;
+        {
+            std::lock_guard<std::mutex> lock(slab_mutex_);
+            slabs_.push_back(s);
+        }
+
+        char* first = static_cast<char*>(s.base);
+        std::size_t count = size / block;
+        free_list& shared = shared_[size_class];
+        std::lock_guard<spin_mutex> lock(shared.mutex);
+        for (std::size_t i = 1; i < count; ++i)
+            shared.blocks.push_back(reinterpret_cast<header*>(first + i * block));
+        return reinterpret_cast<header*>(first);
+    }
+
+    header* acquire(std::size_t size_class)
+    {
+        free_list& local = caches_[thread_index()][size_class];
+        std::lock_guard<spin_mutex> lock(local.mutex);
+
+        if (local.blocks.empty()) {
+            free_list& shared = shared_[size_class];
+            std::lock_guard<spin_mutex> shared_lock(shared.mutex);
+            std::size_t n = std::min(shared.blocks.size(), cache_limit / 2);
+            local.blocks.insert(local.blocks.end(), shared.blocks.end() - n, shared.blocks.end());
+            shared.blocks.resize(shared.blocks.size() - n);
+        }
+
+        if (local.blocks.empty()) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return grow(size_class);
+        }
+
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        header* h = local.blocks.back();
+        local.blocks.pop_back();
+        return h;
+    }
+
+    void release(header* h)
+    {
+        releases_.fetch_add(1, std::memory_order_relaxed);
+
+        std::uint32_t size_class = h->owner.size_class;
+        if (size_class == oversize_class) {
+            std::free(h);
+            return;
+        }
+
+        free_list& local = caches_[thread_index()][size_class];
+        std::lock_guard<spin_mutex> lock(local.mutex);
+        if (local.blocks.size() >= cache_limit) {
+            // Hand half of the cache back so that producers on other threads can refill.
+            free_list& shared = shared_[size_class];
+            std::lock_guard<spin_mutex> shared_lock(shared.mutex);
+            shared.blocks.insert(shared.blocks.end(), local.blocks.begin() + cache_limit / 2,
+                                 local.blocks.end());
+            local.blocks.resize(cache_limit / 2);
+        }
+        local.blocks.push_back(h);
+    }
+
+    static void release_payload(void*, void* hint)
+    {
+        header* h = static_cast<header*>(hint);
+        h->owner.pool->release(h);
+    }
+
+public:
+    explicit frame_pool(std::size_t max_size = std::size_t(4) << 20, bool hugepages = false)
+        : max_size_(max_size),
+          max_class_(class_of(max_size)),
+          hugepages_(hugepages),
+          hits_(0),
+          misses_(0),
+          oversize_(0),
+          releases_(0)
+    {
+        if (max_class_ >= class_count) {
+            max_class_ = class_count - 1;
+            max_size_ = std::size_t(1) << (max_class_ + min_shift);
+        }
+    }
+
+    frame_pool(frame_pool const&) = delete;
+    frame_pool& operator=(frame_pool const&) = delete;
+
+    ~frame_pool()
+    {
+        for (auto& s : slabs_) {
+            if (s.mapped)
+                ::munmap(s.base, s.size);
+            else
+                ::operator delete(s.base);
+        }
+    }
+
+    std::size_t max_size() const { return max_size_; }
+
+    // Returns a frame of the given size whose payload belongs to the pool. Payloads small
+    // enough to be stored inside the zmq_msg_t do not touch the pool at all.
+    frame make_frame(std::size_t size)
+    {
+        if (size <= frame::copy_threshold) return frame(size);
+
+        header* h;
+        if (size > max_size_) {
+            oversize_.fetch_add(1, std::memory_order_relaxed);
+            h = static_cast<header*>(std::malloc(sizeof(header) + size));
+            if (h == nullptr) throw std::bad_alloc();
+            h->owner.size_class = oversize_class;
+        } else {
+            std::size_t size_class = class_of(size);
+            h = acquire(size_class);
+            h->owner.size_class = static_cast<std::uint32_t>(size_class);
+        }
+        h->owner.pool = this;
+
+        frame tmp;
+        zmq_msg_close(&tmp.raw_msg_);
+        tmp.init_data(h + 1, size, &frame_pool::release_payload, h);
+        return tmp;
+    }
+
+    frame_pool_stats stats() const
+    {
+        frame_pool_stats s;
+        s.hits = hits_.load(std::memory_order_relaxed);
+        s.misses = misses_.load(std::memory_order_relaxed);
+        s.oversize = oversize_.load(std::memory_order_relaxed);
+        s.releases = releases_.load(std::memory_order_relaxed);
+        return s;
+    }
+};
+
+}  // namespace zmq
+}  // namespace asio
+}  // namespace boost
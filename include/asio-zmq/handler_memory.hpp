@@ -0,0 +1,356 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <tuple>
+#include <utility>
+#include <boost/asio/detail/handler_alloc_helpers.hpp>
+#include <boost/asio/detail/handler_cont_helpers.hpp>
+#include <boost/asio/detail/handler_invoke_helpers.hpp>
+#include <boost/version.hpp>
+#include "helpers.hpp"
+
+namespace boost {
+namespace asio {
+namespace zmq {
+namespace detail {
+
+// Keeps the blocks released by a socket's intermediate handlers and hands them out again,
+// so that a steady stream of operations cycles through the same few blocks instead of the
+// heap. Blocks are cached by capacity; a request is served by the first cached block that is
+// large enough.
+//
+// Operations can outlive their socket: destroying a socket leaves its pending operations
+// queued, aborted, on the io_service, which frees them later. Each block therefore records the
+// pool it came from, and the pool lives until the socket and every outstanding block are gone;
+// blocks that come back after the socket has been destroyed go straight to the heap. For the
+// same reason an operation that can be woken after its socket is gone holds a lifeline, which
+// keeps the pool alive and tells whether the socket still is.
+class handler_memory {
+private:
+    static std::size_t const cache_size = 8;
+
+    struct pool;
+
+    union header {
+        struct {
+            pool* owner;
+            std::size_t capacity;
+        } info;
+        std::max_align_t align;
+    };
+
+    struct lock_guard {
+        std::atomic_flag& flag_;
+        explicit lock_guard(std::atomic_flag& flag) : flag_(flag)
+        {
+            while (flag_.test_and_set(std::memory_order_acquire)) {
+            }
+        }
+        ~lock_guard() { flag_.clear(std::memory_order_release); }
+    };
+
+    struct pool {
+        std::array<header*, cache_size> cache_;
+        std::atomic_flag lock_;
+        // One for the socket plus one per block handed out and not yet returned.
+        std::atomic<std::size_t> refs_;
+        std::atomic<bool> orphaned_;
+
+        pool() : cache_(), refs_(1), orphaned_(false)
+        {
+            cache_.fill(nullptr);
+            lock_.clear();
+        }
+
+        void release() noexcept
+        {
+            if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+        }
+    };
+
+    pool* pool_;
+
+public:
+    // Moving a lifeline is free; only taking one from the handler_memory counts a reference.
+    class lifeline {
+    private:
+        pool* pool_;
+
+    public:
+        explicit lifeline(handler_memory& memory) noexcept : pool_(memory.pool_)
+        {
+            pool_->refs_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        lifeline(lifeline const& other) noexcept : pool_(other.pool_)
+        {
+            if (pool_ != nullptr) pool_->refs_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        lifeline(lifeline&& other) noexcept : pool_(other.pool_) { other.pool_ = nullptr; }
+
+        lifeline& operator=(lifeline const&) = delete;
+
+        ~lifeline()
+        {
+            if (pool_ != nullptr) pool_->release();
+        }
+
+        // Whether the socket the handler_memory belongs to has not been destroyed yet.
+        bool alive() const noexcept { return !pool_->orphaned_.load(std::memory_order_acquire); }
+    };
+
+    handler_memory() : pool_(new pool()) {}
+
+    handler_memory(handler_memory const&) = delete;
+    handler_memory& operator=(handler_memory const&) = delete;
+
+    ~handler_memory()
+    {
+        {
+            lock_guard guard(pool_->lock_);
+            pool_->orphaned_.store(true, std::memory_order_release);
+            for (auto& block : pool_->cache_) {
+                ::operator delete(block);
+                block = nullptr;
+            }
+        }
+        pool_->release();
+    }
+
+    void* allocate(std::size_t size)
+    {
+        pool_->refs_.fetch_add(1, std::memory_order_relaxed);
+        {
+            lock_guard guard(pool_->lock_);
+            for (auto& block : pool_->cache_) {
+                if (block != nullptr && block->info.capacity >= size) {
+                    header* h = block;
+                    block = nullptr;
+                    return h + 1;
+                }
+            }
+        }
+
+        header* h = static_cast<header*>(::operator new(sizeof(header) + size));
+        h->info.owner = pool_;
+        h->info.capacity = size;
+        return h + 1;
+    }
+
+    // Static, as the socket whose memory p came from may no longer exist.
+    static void deallocate(void* p) noexcept
+    {
+        header* h = static_cast<header*>(p) - 1;
+        pool* owner = h->info.owner;
+        bool cached = false;
+        {
+            lock_guard guard(owner->lock_);
+            if (!owner->orphaned_.load(std::memory_order_relaxed)) {
+                for (auto& block : owner->cache_) {
+                    if (block == nullptr) {
+                        block = h;
+                        cached = true;
+                        break;
+                    }
+                }
+            }
+        }
+        if (!cached) ::operator delete(h);
+        owner->release();
+    }
+};
+
+// Allocator view of a handler_memory, exposed as the associated allocator of the socket's
+// intermediate handlers for Asio versions that look for one.
+template <typename T> class recycling_allocator {
+    template <typename U> friend class recycling_allocator;
+
+private:
+    handler_memory* memory_;
+
+public:
+    typedef T value_type;
+
+    explicit recycling_allocator(handler_memory& memory) noexcept : memory_(&memory) {}
+
+    template <typename U>
+    recycling_allocator(recycling_allocator<U> const& other) noexcept : memory_(other.memory_)
+    {
+    }
+
+    template <typename U> struct rebind {
+        typedef recycling_allocator<U> other;
+    };
+
+    T* allocate(std::size_t n) { return static_cast<T*>(memory_->allocate(sizeof(T) * n)); }
+
+    void deallocate(T* p, std::size_t) noexcept { handler_memory::deallocate(p); }
+
+    template <typename U> bool operator==(recycling_allocator<U> const& other) const noexcept
+    {
+        return memory_ == other.memory_;
+    }
+
+    template <typename U> bool operator!=(recycling_allocator<U> const& other) const noexcept
+    {
+        return memory_ != other.memory_;
+    }
+};
+
+// Hands a function to the user's invocation hook without the function's own allocation hooks.
+// A strand-wrapped handler queues the function it is given, and some Asio releases allocate that
+// queue entry through the function's hooks but free it through the handler's, which would return
+// a handler_memory block to Asio's recycling cache.
+template <typename Function> class unhooked_function {
+private:
+    Function func_;
+
+public:
+    explicit unhooked_function(Function&& func) : func_(std::move(func)) {}
+
+    void operator()() { func_(); }
+};
+
+// Base of every intermediate handler a socket passes to Asio. Memory for the handler's
+// operation comes from the socket's handler_memory unless the user's handler has an allocator
+// of its own. The user's executor, invocation and continuation hints are forwarded so that
+// handlers bound to a strand, or coroutines spawned on one, keep their guarantees.
+template <typename Handler> class memory_bound_handler : public handler_holder<Handler> {
+protected:
+    handler_memory* memory_;
+
+public:
+#if BOOST_VERSION >= 106600
+    typedef typename associated_allocator<Handler, recycling_allocator<void>>::type allocator_type;
+#else
+    typedef recycling_allocator<void> allocator_type;
+#endif
+
+    memory_bound_handler(handler_memory& memory, Handler&& handler)
+        : handler_holder<Handler>(std::move(handler)), memory_(&memory)
+    {
+    }
+
+#if BOOST_VERSION >= 106600
+    allocator_type get_allocator() const noexcept
+    {
+        return boost::asio::get_associated_allocator(this->handler_,
+                                                     recycling_allocator<void>(*memory_));
+    }
+#else
+    allocator_type get_allocator() const noexcept { return allocator_type(*memory_); }
+#endif
+
+    friend void* asio_handler_allocate(std::size_t size, memory_bound_handler* self)
+    {
+        return self->memory_->allocate(size);
+    }
+
+    friend void asio_handler_deallocate(void* p, std::size_t, memory_bound_handler*)
+    {
+        handler_memory::deallocate(p);
+    }
+
+    template <typename Function>
+    friend void asio_handler_invoke(Function& func, memory_bound_handler* self)
+    {
+        unhooked_function<Function> unhooked(std::move(func));
+        boost_asio_handler_invoke_helpers::invoke(unhooked, self->handler_);
+    }
+
+    template <typename Function>
+    friend void asio_handler_invoke(Function const& func, memory_bound_handler* self)
+    {
+        unhooked_function<Function> unhooked{Function(func)};
+        boost_asio_handler_invoke_helpers::invoke(unhooked, self->handler_);
+    }
+
+    friend bool asio_handler_is_continuation(memory_bound_handler* self)
+    {
+        return boost_asio_handler_cont_helpers::is_continuation(self->handler_);
+    }
+};
+
+// An intermediate handler with its executor left out, for an operation whose handler's executor
+// runs on the socket's io_service anyway: given an executor, Asio would submit the operation to
+// it on every wake-up rather than invoke it directly. Everything else is forwarded.
+template <typename Op> class unbound_handler {
+private:
+    Op op_;
+
+public:
+    typedef typename Op::allocator_type allocator_type;
+
+    explicit unbound_handler(Op&& op) : op_(std::move(op)) {}
+
+    allocator_type get_allocator() const noexcept { return op_.get_allocator(); }
+
+    template <typename... Args> void operator()(Args const&... args) { op_(args...); }
+
+    friend void* asio_handler_allocate(std::size_t size, unbound_handler* self)
+    {
+        return boost_asio_handler_alloc_helpers::allocate(size, self->op_);
+    }
+
+    friend void asio_handler_deallocate(void* p, std::size_t size, unbound_handler* self)
+    {
+        boost_asio_handler_alloc_helpers::deallocate(p, size, self->op_);
+    }
+
+    template <typename Function>
+    friend void asio_handler_invoke(Function& func, unbound_handler* self)
+    {
+        boost_asio_handler_invoke_helpers::invoke(func, self->op_);
+    }
+
+    template <typename Function>
+    friend void asio_handler_invoke(Function const& func, unbound_handler* self)
+    {
+        boost_asio_handler_invoke_helpers::invoke(func, self->op_);
+    }
+
+    friend bool asio_handler_is_continuation(unbound_handler* self)
+    {
+        return boost_asio_handler_cont_helpers::is_continuation(self->op_);
+    }
+};
+
+template <std::size_t...> struct index_sequence {
+};
+
+template <std::size_t N, std::size_t... Is>
+struct make_index_sequence : make_index_sequence<N - 1, N - 1, Is...> {
+};
+
+template <std::size_t... Is> struct make_index_sequence<0, Is...> : index_sequence<Is...> {
+};
+
+// A user handler together with the arguments it is to be completed with, ready to be posted
+// or dispatched through the socket's io_service.
+template <typename Handler, typename... Args>
+class completion_handler : public memory_bound_handler<Handler> {
+private:
+    std::tuple<Args...> args_;
+
+    template <std::size_t... Is> void invoke(index_sequence<Is...>)
+    {
+        this->handler_(static_cast<Args const&>(std::get<Is>(args_))...);
+    }
+
+public:
+    completion_handler(handler_memory& memory, Handler&& handler, Args const&... args)
+        : memory_bound_handler<Handler>(memory, std::move(handler)), args_(args...)
+    {
+    }
+
+    void operator()() { invoke(make_index_sequence<sizeof...(Args)>()); }
+};
+
+}  // namespace detail
+}  // namespace zmq
+}  // namespace asio
+}  // namespace boost
@@ -1,14 +1,31 @@
 #pragma once
 
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <boost/version.hpp>
+#include <boost/asio/async_result.hpp>
 #include <boost/asio/io_service.hpp>
 #include <boost/asio/posix/basic_stream_descriptor.hpp>
+#if BOOST_VERSION < 106600
 #include <boost/asio/posix/stream_descriptor_service.hpp>
+#else
+#include <boost/asio/associated_allocator.hpp>
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+#endif
 #include <zmq.h>
 
 namespace boost {
 namespace asio {
 namespace zmq {
 
+// The ZMQ_FD descriptor belongs to ZeroMQ, so the descriptor object must never close it.
+#if BOOST_VERSION < 106600
 template <typename IoObjectService> struct non_closing_io_object_service : public IoObjectService {
     explicit non_closing_io_object_service(io_service& io) : IoObjectService(io) {}
 
@@ -18,9 +35,302 @@ template <typename IoObjectService> struct non_closing_io_object_service : publi
 typedef non_closing_io_object_service<posix::stream_descriptor_service> descriptor_service;
 
 typedef posix::basic_stream_descriptor<descriptor_service> descriptor_type;
+#else
+// Newer Asio has no per-object services; release the descriptor before it would be closed.
+class descriptor_type : public posix::stream_descriptor {
+public:
+    explicit descriptor_type(io_service& io) : posix::stream_descriptor(io) {}
+
+    ~descriptor_type()
+    {
+        if (is_open()) release();
+    }
+};
+#endif
 
 typedef descriptor_type::native_handle_type native_handle_type;
 
+namespace detail {
+
+// Turns a completion token into a handler, starts the operation with it and returns whatever
+// the token's async_result produces: nothing for plain callbacks, a future for use_future, the
+// result of the operation for yield_context, an awaitable for use_awaitable.
+#if BOOST_VERSION >= 107000
+using boost::asio::async_initiate;
+#else
+template <typename CompletionToken, typename Signature, typename Initiation, typename... Args>
+BOOST_ASIO_INITFN_RESULT_TYPE(typename std::decay<CompletionToken>::type, Signature)
+async_initiate(Initiation&& initiation, CompletionToken& token, Args&&... args)
+{
+    typedef typename handler_type<typename std::decay<CompletionToken>::type, Signature>::type
+        handler_type;
+    handler_type handler(std::forward<CompletionToken>(token));
+    async_result<handler_type> result(handler);
+    std::forward<Initiation>(initiation)(std::move(handler), std::forward<Args>(args)...);
+    return result.get();
+}
+#endif
+
+#if BOOST_VERSION >= 106600
+// Stands in for the default executor and allocator to find out whether a handler comes with an
+// executor or allocator of its own.
+struct unassociated {
+};
+
+template <typename Handler>
+struct has_executor
+    : std::integral_constant<
+          bool, !std::is_same<typename associated_executor<Handler, unassociated>::type,
+                              unassociated>::value> {
+};
+
+template <typename Handler>
+struct has_allocator
+    : std::integral_constant<
+          bool, !std::is_same<typename associated_allocator<Handler, unassociated>::type,
+                              unassociated>::value> {
+};
+
+// Whether functions submitted to ex run on io itself, as they do for a coroutine spawned on io.
+inline bool runs_on(io_service::executor_type const& ex, io_service& io)
+{
+    return ex == io.get_executor();
+}
+
+// target() does not check the type of the target on every release, so target_type() is
+// consulted first; without RTTI a polymorphic executor is taken to run elsewhere.
+#if BOOST_VERSION >= 107400
+inline bool runs_on(any_io_executor const& ex, io_service& io)
+{
+#if !defined(BOOST_ASIO_NO_TYPEID)
+    return ex.target_type() == typeid(io_service::executor_type) &&
+           *ex.target<io_service::executor_type>() == io.get_executor();
+#else
+    return false;
+#endif
+}
+#endif
+
+template <typename Executor> bool runs_on(Executor const&, io_service&) { return false; }
+
+// Holds the user's handler for one of the socket's wrappers. Asio runs a wrapper on the
+// executor associated with the wrapper, so a handler with an executor of its own lends it to
+// the wrapper; a handler without one leaves the wrapper without one too, and Asio then runs it
+// on the io_service without the cost of an executor indirection.
+template <typename Handler, bool = has_executor<Handler>::value> class handler_holder {
+protected:
+    Handler handler_;
+
+    explicit handler_holder(Handler&& handler) : handler_(std::move(handler)) {}
+};
+
+template <typename Handler> class handler_holder<Handler, true> {
+protected:
+    Handler handler_;
+
+    explicit handler_holder(Handler&& handler) : handler_(std::move(handler)) {}
+
+public:
+    typedef typename associated_executor<Handler>::type executor_type;
+
+    executor_type get_executor() const noexcept
+    {
+        return boost::asio::get_associated_executor(handler_);
+    }
+};
+
+// As handler_holder, for a wrapper that may be asked for the executor after its handler has
+// been moved out: the executor is copied from the handler when it is wrapped.
+template <typename Handler, bool = has_executor<Handler>::value> class executor_binding {
+public:
+    explicit executor_binding(Handler const&) {}
+};
+
+template <typename Handler> class executor_binding<Handler, true> {
+public:
+    typedef typename associated_executor<Handler>::type executor_type;
+
+    explicit executor_binding(Handler const& handler)
+        : executor_(boost::asio::get_associated_executor(handler))
+    {
+    }
+
+    executor_type get_executor() const noexcept { return executor_; }
+
+private:
+    executor_type executor_;
+};
+
+// As executor_binding, for the allocator of a handler that has one of its own.
+template <typename Handler, bool = has_allocator<Handler>::value> class allocator_binding {
+public:
+    explicit allocator_binding(Handler const&) {}
+};
+
+template <typename Handler> class allocator_binding<Handler, true> {
+public:
+    typedef typename associated_allocator<Handler>::type allocator_type;
+
+    explicit allocator_binding(Handler const& handler)
+        : allocator_(boost::asio::get_associated_allocator(handler))
+    {
+    }
+
+    allocator_type get_allocator() const noexcept { return allocator_; }
+
+private:
+    allocator_type allocator_;
+};
+
+// Counts as outstanding work on the executor of a handler the socket holds on to, such as that
+// of a queued write, so that an io_service the handler is to run on does not run out of work
+// meanwhile. The socket's own io_service is kept busy by the socket's waits and needs none.
+// Moved out of its operation before the handler is completed, so that the work only ends once
+// the handler has been submitted to the executor.
+template <typename Handler, bool = has_executor<Handler>::value> class handler_work {
+public:
+    handler_work(Handler const&, io_service&) {}
+};
+
+template <typename Handler> class handler_work<Handler, true> {
+private:
+    typedef executor_work_guard<typename associated_executor<Handler>::type> guard_type;
+
+    union {
+        guard_type guard_;
+    };
+    bool owns_;
+
+public:
+    handler_work(Handler const& handler, io_service& io)
+        : owns_(!runs_on(boost::asio::get_associated_executor(handler), io))
+    {
+        if (owns_) new (&guard_) guard_type(boost::asio::get_associated_executor(handler));
+    }
+
+    handler_work(handler_work&& other) noexcept : owns_(other.owns_)
+    {
+        if (owns_) new (&guard_) guard_type(std::move(other.guard_));
+    }
+
+    handler_work& operator=(handler_work const&) = delete;
+
+    ~handler_work()
+    {
+        if (owns_) guard_.~guard_type();
+    }
+};
+
+// Submits a handler whose executor runs on io to io directly: Asio would otherwise route it
+// through a dispatcher that submits it again, to the executor, from io.
+template <typename Handler> void post_direct(io_service& io, Handler&& handler)
+{
+    auto alloc = boost::asio::get_associated_allocator(handler);
+#if BOOST_VERSION >= 107400
+    execution::execute(boost::asio::prefer(boost::asio::require(io.get_executor(),
+                                                                execution::blocking.never),
+                                           execution::relationship.fork,
+                                           execution::allocator(alloc)),
+                       std::forward<Handler>(handler));
+#else
+    io.get_executor().post(std::forward<Handler>(handler), alloc);
+#endif
+}
+
+template <typename Handler> void dispatch_direct(io_service& io, Handler&& handler)
+{
+    auto alloc = boost::asio::get_associated_allocator(handler);
+#if BOOST_VERSION >= 107400
+    execution::execute(boost::asio::prefer(io.get_executor(), execution::blocking.possibly,
+                                           execution::allocator(alloc)),
+                       std::forward<Handler>(handler));
+#else
+    io.get_executor().dispatch(std::forward<Handler>(handler), alloc);
+#endif
+}
+
+template <typename Handler>
+void post(io_service& io, Handler&& handler, std::false_type)
+{
+    boost::asio::post(io, std::forward<Handler>(handler));
+}
+
+template <typename Handler>
+void post(io_service& io, Handler&& handler, std::true_type)
+{
+    if (runs_on(boost::asio::get_associated_executor(handler), io))
+        post_direct(io, std::forward<Handler>(handler));
+    else
+        boost::asio::post(io, std::forward<Handler>(handler));
+}
+
+template <typename Handler>
+void dispatch(io_service& io, Handler&& handler, std::false_type)
+{
+    boost::asio::dispatch(io, std::forward<Handler>(handler));
+}
+
+template <typename Handler>
+void dispatch(io_service& io, Handler&& handler, std::true_type)
+{
+    if (runs_on(boost::asio::get_associated_executor(handler), io))
+        dispatch_direct(io, std::forward<Handler>(handler));
+    else
+        boost::asio::dispatch(io, std::forward<Handler>(handler));
+}
+#else
+template <typename Handler> class handler_holder {
+protected:
+    Handler handler_;
+
+    explicit handler_holder(Handler&& handler) : handler_(std::move(handler)) {}
+};
+
+template <typename Handler> class executor_binding {
+public:
+    explicit executor_binding(Handler const&) {}
+};
+
+template <typename Handler> class allocator_binding {
+public:
+    explicit allocator_binding(Handler const&) {}
+};
+
+template <typename Handler> class handler_work {
+public:
+    handler_work(Handler const&, io_service&) {}
+};
+#endif
+
+// Completes a handler through io, on the executor associated with the handler if it has one.
+// io_service::post and dispatch insist on copyable handlers; the free functions that replaced
+// them also take move-only ones such as coroutine continuations.
+template <typename Handler> void post(io_service& io, Handler&& handler)
+{
+#if BOOST_VERSION >= 106600
+    typedef typename std::decay<Handler>::type handler_type;
+    detail::post(io, std::forward<Handler>(handler), has_executor<handler_type>());
+#else
+    io.post(std::forward<Handler>(handler));
+#endif
+}
+
+template <typename Handler> void dispatch(io_service& io, Handler&& handler)
+{
+#if BOOST_VERSION >= 106600
+    typedef typename std::decay<Handler>::type handler_type;
+    detail::dispatch(io, std::forward<Handler>(handler), has_executor<handler_type>());
+#else
+    io.dispatch(std::forward<Handler>(handler));
+#endif
+}
+
+template <typename CompletionToken, typename Signature>
+using initfn_result_t =
+    BOOST_ASIO_INITFN_RESULT_TYPE(typename std::decay<CompletionToken>::type, Signature);
+
+}  // namespace detail
+
 struct socket_deleter {
     void operator()(void* sock) noexcept { zmq_close(sock); }
 };
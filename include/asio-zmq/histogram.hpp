@@ -0,0 +1,187 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace boost {
+namespace asio {
+namespace zmq {
+
+// Log-linear histogram of non-negative integer samples, typically nanoseconds. Each power of
+// two is split into 16 equal buckets, so a recorded value is known to within 1/16 (6.25%) of
+// itself, and values below 16 are exact. Samples of 2^40 and more (about 18 minutes in
+// nanoseconds) land in the last bucket. Recording is a few arithmetic operations and one
+// increment; the buckets take under 5 KiB.
+class histogram {
+public:
+    static std::size_t const sub_bucket_bits = 4;
+    static std::size_t const sub_buckets = std::size_t(1) << sub_bucket_bits;
+    static std::size_t const max_bits = 40;
+    static std::size_t const bucket_count = (max_bits - sub_bucket_bits + 1) * sub_buckets;
+
+    static std::size_t bucket_of(std::uint64_t value)
+    {
+        if (value < sub_buckets) return static_cast<std::size_t>(value);
+        if (value >= (std::uint64_t(1) << max_bits)) return bucket_count - 1;
+
+        std::size_t msb = highest_bit(value);
+        std::size_t sub = static_cast<std::size_t>(value >> (msb - sub_bucket_bits)) &
+                          (sub_buckets - 1);
+        return (msb - sub_bucket_bits + 1) * sub_buckets + sub;
+    }
+
+    // Smallest value that falls into bucket index.
+    static std::uint64_t lower_bound(std::size_t index)
+    {
+        if (index < sub_buckets) return index;
+
+        std::size_t msb = index / sub_buckets + sub_bucket_bits - 1;
+        std::uint64_t sub = index % sub_buckets;
+        return (sub_buckets + sub) << (msb - sub_bucket_bits);
+    }
+
+    // Largest value that falls into bucket index.
+    static std::uint64_t upper_bound(std::size_t index)
+    {
+        if (index + 1 >= bucket_count) return std::numeric_limits<std::uint64_t>::max();
+        return lower_bound(index + 1) - 1;
+    }
+
+    histogram() : counts_(), count_(0), sum_(0), min_(0), max_(0) { counts_.fill(0); }
+
+    void record(std::uint64_t value)
+    {
+        ++counts_[bucket_of(value)];
+        if (count_ == 0 || value < min_) min_ = value;
+        if (value > max_) max_ = value;
+        sum_ += value;
+        ++count_;
+    }
+
+    void merge(histogram const& other)
+    {
+        if (other.count_ == 0) return;
+        for (std::size_t i = 0; i < bucket_count; ++i) counts_[i] += other.counts_[i];
+        if (count_ == 0 || other.min_ < min_) min_ = other.min_;
+        if (other.max_ > max_) max_ = other.max_;
+        sum_ += other.sum_;
+        count_ += other.count_;
+    }
+
+    void clear() { *this = histogram(); }
+
+    std::uint64_t count() const { return count_; }
+
+    std::uint64_t min() const { return min_; }
+
+    std::uint64_t max() const { return max_; }
+
+    double mean() const { return count_ == 0 ? 0.0 : static_cast<double>(sum_) / count_; }
+
+    std::uint64_t bucket(std::size_t index) const { return counts_[index]; }
+
+    // The value below or at which percentile percent of the samples lie, reported as the upper
+    // bound of its bucket but never above the largest sample. 0 when empty.
+    std::uint64_t value_at(double percentile) const
+    {
+        if (count_ == 0) return 0;
+        if (percentile >= 100.0) return max_;
+
+        std::uint64_t rank = static_cast<std::uint64_t>(percentile / 100.0 * count_);
+        if (rank >= count_) rank = count_ - 1;
+
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            seen += counts_[i];
+            if (seen > rank) {
+                std::uint64_t value = upper_bound(i);
+                if (value > max_) value = max_;
+                if (value < min_) value = min_;
+                return value;
+            }
+        }
+        return max_;
+    }
+
+private:
+    friend class atomic_histogram;
+
+    std::array<std::uint64_t, bucket_count> counts_;
+    std::uint64_t count_;
+    std::uint64_t sum_;
+    std::uint64_t min_;
+    std::uint64_t max_;
+
+    static std::size_t highest_bit(std::uint64_t value)
+    {
+#if defined(__GNUC__)
+        return 63 - static_cast<std::size_t>(__builtin_clzll(value));
+#else
+        std::size_t bit = 0;
+        while (value >>= 1) ++bit;
+        return bit;
+#endif
+    }
+};
+
+// A histogram that any number of threads record into with relaxed atomics while others take
+// snapshots. A snapshot taken during recording may be off by the samples in flight.
+class atomic_histogram {
+private:
+    typedef std::atomic<std::uint64_t> counter;
+
+    std::array<counter, histogram::bucket_count> counts_;
+    counter count_;
+    counter sum_;
+    // min_ starts above any sample, so that the first one replaces it without a test of count_.
+    counter min_;
+    counter max_;
+
+    static void add(counter& c, std::uint64_t n) { c.fetch_add(n, std::memory_order_relaxed); }
+
+public:
+    atomic_histogram()
+        : count_(0), sum_(0), min_(std::numeric_limits<std::uint64_t>::max()), max_(0)
+    {
+        for (auto& c : counts_) c.store(0, std::memory_order_relaxed);
+    }
+
+    atomic_histogram(atomic_histogram const&) = delete;
+    atomic_histogram& operator=(atomic_histogram const&) = delete;
+
+    // A new extreme is rare once a few samples are in, so min and max are usually one load each.
+    void record(std::uint64_t value)
+    {
+        add(counts_[histogram::bucket_of(value)], 1);
+        std::uint64_t low = min_.load(std::memory_order_relaxed);
+        while (value < low &&
+               !min_.compare_exchange_weak(low, value, std::memory_order_relaxed)) {
+        }
+        std::uint64_t high = max_.load(std::memory_order_relaxed);
+        while (value > high &&
+               !max_.compare_exchange_weak(high, value, std::memory_order_relaxed)) {
+        }
+        add(sum_, value);
+        add(count_, 1);
+    }
+
+    histogram snapshot() const
+    {
+        histogram result;
+        for (std::size_t i = 0; i < histogram::bucket_count; ++i)
+            result.counts_[i] = counts_[i].load(std::memory_order_relaxed);
+        result.count_ = count_.load(std::memory_order_relaxed);
+        result.sum_ = sum_.load(std::memory_order_relaxed);
+        std::uint64_t low = min_.load(std::memory_order_relaxed);
+        result.min_ = low == std::numeric_limits<std::uint64_t>::max() ? 0 : low;
+        result.max_ = max_.load(std::memory_order_relaxed);
+        return result;
+    }
+};
+
+}  // namespace zmq
+}  // namespace asio
+}  // namespace boost
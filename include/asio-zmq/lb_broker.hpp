@@ -0,0 +1,291 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <zmq.h>
+#include "helpers.hpp"
+#include "device.hpp"
+#include "exception.hpp"
+#include "frame.hpp"
+#include "message.hpp"
+#include "socket.hpp"
+
+namespace boost {
+namespace asio {
+namespace zmq {
+
+struct lb_broker_statistics {
+    std::uint64_t requests;          // client requests handed to a worker
+    std::uint64_t replies;           // worker replies handed back to a client
+    std::size_t ready_workers;       // workers waiting for a request
+    std::size_t peak_ready_workers;  // most workers that have waited at once
+    std::size_t known_workers;       // workers that have announced themselves
+};
+
+// The least-recently-used load-balancing broker of the ZeroMQ guide as a device. Clients
+// connect their REQ (or DEALER) sockets to the frontend ROUTER, workers connect REQ sockets to
+// the backend ROUTER and announce themselves with any one-frame message, then answer each
+// request [client][""][request...] with [client][""][reply...].
+//
+// Ready workers are kept in an intrusive FIFO list threaded through a hash table keyed by the
+// bytes of their routing id frames, so routing a request or taking back a worker is O(1) and
+// never converts ids to strings or allocates; only a worker's first message adds an entry. The
+// frontend is only read while a worker is ready, up to batch_size requests per wakeup, so
+// requests queue up in ZeroMQ rather than in the broker when every worker is busy.
+//
+// If the backend sets ZMQ_ROUTER_MANDATORY, a request routed to a worker that has disconnected
+// is handed to the next ready worker and the stale one is forgotten.
+class lb_broker : public detail::basic_device<lb_broker, 2> {
+private:
+    friend class detail::basic_device<lb_broker, 2>;
+
+    using size_t = std::size_t;
+
+    enum { frontend_index, backend_index };
+
+    // Views the id bytes owned by the worker it indexes, or by a received frame for lookups.
+    struct routing_key {
+        void const* data_;
+        size_t size_;
+    };
+
+    struct routing_key_hash {
+        size_t operator()(routing_key const& key) const
+        {
+            // FNV-1a; routing ids are short, so one pass over the bytes is cheap.
+            std::uint64_t hash = 14695981039346656037ull;
+            unsigned char const* p = static_cast<unsigned char const*>(key.data_);
+            for (size_t i = 0; i < key.size_; ++i) {
+                hash ^= p[i];
+                hash *= 1099511628211ull;
+            }
+            return static_cast<size_t>(hash);
+        }
+    };
+
+    struct routing_key_equal {
+        bool operator()(routing_key const& lhs, routing_key const& rhs) const
+        {
+            return lhs.size_ == rhs.size_ && std::memcmp(lhs.data_, rhs.data_, lhs.size_) == 0;
+        }
+    };
+
+    struct worker {
+        frame id_;
+        worker* prev_;
+        worker* next_;
+        bool ready_;
+
+        explicit worker(frame const& id) : id_(id), prev_(nullptr), next_(nullptr), ready_(false)
+        {
+        }
+
+        routing_key key() const { return routing_key{id_.data(), id_.size()}; }
+    };
+
+    typedef std::unordered_map<routing_key, std::unique_ptr<worker>, routing_key_hash,
+                               routing_key_equal>
+        worker_map;
+
+    typedef basic_message<8> message_type;
+
+    worker_map workers_;
+    worker* ready_front_;
+    worker* ready_back_;
+    lb_broker_statistics stats_;
+    message_type request_;
+    message_type reply_;
+    bool request_pending_;
+    bool reply_pending_;
+
+    void push_ready(worker* w)
+    {
+        if (w->ready_) return;
+        w->ready_ = true;
+        w->prev_ = ready_back_;
+        w->next_ = nullptr;
+        if (ready_back_ != nullptr)
+            ready_back_->next_ = w;
+        else
+            ready_front_ = w;
+        ready_back_ = w;
+        if (++stats_.ready_workers > stats_.peak_ready_workers)
+            stats_.peak_ready_workers = stats_.ready_workers;
+    }
+
+    void unlink_ready(worker* w)
+    {
+        if (!w->ready_) return;
+        w->ready_ = false;
+        if (w->prev_ != nullptr)
+            w->prev_->next_ = w->next_;
+        else
+            ready_front_ = w->next_;
+        if (w->next_ != nullptr)
+            w->next_->prev_ = w->prev_;
+        else
+            ready_back_ = w->prev_;
+        w->prev_ = w->next_ = nullptr;
+        --stats_.ready_workers;
+    }
+
+    worker* find_or_add(frame const& id)
+    {
+        routing_key key{id.data(), id.size()};
+        auto it = workers_.find(key);
+        if (it != workers_.end()) return it->second.get();
+
+        // The entry's key must view the worker's own copy of the id, not the received frame.
+        std::unique_ptr<worker> w(new worker(id));
+        worker* raw = w.get();
+        workers_.emplace(raw->key(), std::move(w));
+        stats_.known_workers = workers_.size();
+        return raw;
+    }
+
+    void erase(worker* w)
+    {
+        unlink_ready(w);
+        workers_.erase(workers_.find(w->key()));
+        stats_.known_workers = workers_.size();
+    }
+
+    // Hands the client envelope and reply of reply_ to the frontend.
+    bool try_send_reply()
+    {
+        if (!sockets_[frontend_index]->try_write_message(reply_.begin() + 2, reply_.end()))
+            return false;
+        reply_pending_ = false;
+        ++stats_.replies;
+        return true;
+    }
+
+    // Takes back the workers that have answered and forwards their replies.
+    bool step_backend()
+    {
+        socket& backend = *sockets_[backend_index];
+        size_t count = 0;
+        while (count < batch_size) {
+            if (reply_pending_ && !try_send_reply()) break;
+
+            reply_.clear();
+            auto buff_it = std::back_inserter(reply_);
+            if (!backend.try_read_message(buff_it)) break;
+            ++count;
+
+            push_ready(find_or_add(reply_[0]));
+            // [worker][""][client][""][reply...] carries a reply; [worker][""][ready] does not.
+            if (reply_.size() > 3) reply_pending_ = true;
+        }
+        return count > 0;
+    }
+
+    // Routes [worker][""] + request_ to the least recently used ready worker.
+    bool try_send_request()
+    {
+        socket& backend = *sockets_[backend_index];
+        while (ready_front_ != nullptr) {
+            worker* w = ready_front_;
+            frame id(w->id_);
+            try {
+                if (!backend.try_write_frame(id, ZMQ_SNDMORE)) return false;
+            }
+            catch (exception const& e) {
+                if (e.get_code().value() != EHOSTUNREACH) throw;
+                erase(w);
+                continue;
+            }
+            backend.write_frame(frame(), ZMQ_SNDMORE);
+            backend.write_message(request_.begin(), request_.end());
+            unlink_ready(w);
+            request_pending_ = false;
+            ++stats_.requests;
+            return true;
+        }
+        return false;
+    }
+
+    bool step_frontend()
+    {
+        socket& frontend = *sockets_[frontend_index];
+        size_t count = 0;
+        while (ready_front_ != nullptr && count < batch_size) {
+            if (!request_pending_) {
+                request_.clear();
+                auto buff_it = std::back_inserter(request_);
+                if (!frontend.try_read_message(buff_it)) break;
+                request_pending_ = true;
+            }
+            if (!try_send_request()) break;
+            ++count;
+        }
+        return count > 0;
+    }
+
+    bool step()
+    {
+        bool progress = step_backend();
+        return step_frontend() || progress;
+    }
+
+    bool ready()
+    {
+        socket& frontend = *sockets_[frontend_index];
+        socket& backend = *sockets_[backend_index];
+
+        bool result = reply_pending_ ? frontend.is_writable() : backend.is_readable();
+        if (ready_front_ != nullptr) {
+            if (request_pending_)
+                result = backend.is_writable() || result;
+            else
+                result = frontend.is_readable() || result;
+        }
+        return result;
+    }
+
+public:
+    static size_t const batch_size = 256;
+
+    // expected_workers sizes the worker table up front so that it does not rehash while a
+    // large pool of workers announces itself.
+    lb_broker(socket& frontend, socket& backend, size_t expected_workers = 0)
+        : workers_(),
+          ready_front_(nullptr),
+          ready_back_(nullptr),
+          stats_(),
+          request_(),
+          reply_(),
+          request_pending_(false),
+          reply_pending_(false)
+    {
+        sockets_[frontend_index] = &frontend;
+        sockets_[backend_index] = &backend;
+        if (expected_workers > 0) workers_.reserve(expected_workers);
+    }
+
+    // Forgets a worker, e.g. one a socket monitor has seen disconnect. Returns whether it was
+    // known.
+    bool remove_worker(frame const& id)
+    {
+        auto it = workers_.find(routing_key{id.data(), id.size()});
+        if (it == workers_.end()) return false;
+        erase(it->second.get());
+        return true;
+    }
+
+    size_t ready_workers() const { return stats_.ready_workers; }
+
+    size_t known_workers() const { return stats_.known_workers; }
+
+    lb_broker_statistics statistics() const { return stats_; }
+};
+
+}  // namespace zmq
+}  // namespace asio
+}  // namespace boost
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include "frame.hpp"
+
+namespace boost {
+namespace asio {
+namespace zmq {
+
+// A multipart message that keeps up to N frames inline and only moves to the heap for longer
+// messages. Receiving a typical one to three frame message into it allocates nothing beyond
+// the payloads, and clear() keeps any heap capacity for the next message. Frames are stored
+// contiguously, so iterators are plain pointers.
+template <std::size_t N> class basic_message {
+private:
+    std::array<frame, N> inline_;
+    std::vector<frame> spill_;
+    std::size_t size_;
+    bool spilled_;
+
+    frame* storage() { return spilled_ ? spill_.data() : inline_.data(); }
+
+    frame const* storage() const { return spilled_ ? spill_.data() : inline_.data(); }
+
+    void spill()
+    {
+        spill_.reserve(2 * N);
+        for (std::size_t i = 0; i < size_; ++i) spill_.push_back(std::move(inline_[i]));
+        spilled_ = true;
+    }
+
+    // Moves the frames of other, leaving it empty, into this empty message without allocating:
+    // spilled frames come with the vector that holds them and inline ones are moved one by one,
+    // so that containers of messages move rather than copy them when they grow.
+    void take(basic_message& other) noexcept
+    {
+        if (other.spilled_) {
+            spill_ = std::move(other.spill_);
+            spilled_ = true;
+            other.spill_.clear();
+            other.spilled_ = false;
+        } else {
+            for (std::size_t i = 0; i < other.size_; ++i) inline_[i] = std::move(other.inline_[i]);
+        }
+        size_ = other.size_;
+        other.size_ = 0;
+    }
+
+public:
+    typedef frame value_type;
+    typedef frame& reference;
+    typedef frame const& const_reference;
+    typedef frame* iterator;
+    typedef frame const* const_iterator;
+    typedef std::size_t size_type;
+
+    static std::size_t const inline_capacity = N;
+
+    basic_message() : inline_(), spill_(), size_(0), spilled_(false) {}
+
+    basic_message(basic_message&& other) noexcept : basic_message() { take(other); }
+
+    basic_message(basic_message const& other) : basic_message()
+    {
+        for (auto const& frm : other) push_back(frm);
+    }
+
+    basic_message& operator=(basic_message&& other) noexcept
+    {
+        if (this != &other) {
+            clear();
+            take(other);
+        }
+        return *this;
+    }
+
+    basic_message& operator=(basic_message const& other)
+    {
+        if (this != &other) {
+            clear();
+            for (auto const& frm : other) push_back(frm);
+        }
+        return *this;
+    }
+
+    iterator begin() { return storage(); }
+    iterator end() { return storage() + size_; }
+    const_iterator begin() const { return storage(); }
+    const_iterator end() const { return storage() + size_; }
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    frame& operator[](std::size_t i) { return storage()[i]; }
+    frame const& operator[](std::size_t i) const { return storage()[i]; }
+
+    frame& front() { return storage()[0]; }
+    frame const& front() const { return storage()[0]; }
+    frame& back() { return storage()[size_ - 1]; }
+    frame const& back() const { return storage()[size_ - 1]; }
+
+    void push_back(frame&& frm)
+    {
+        if (!spilled_ && size_ == N) spill();
+        if (spilled_)
+            spill_.push_back(std::move(frm));
+        else
+            inline_[size_] = std::move(frm);
+        ++size_;
+    }
+
+    void push_back(frame const& frm) { push_back(frame(frm)); }
+
+    template <typename... Args> void emplace_back(Args&&... args)
+    {
+        push_back(frame(std::forward<Args>(args)...));
+    }
+
+    void pop_back()
+    {
+        if (spilled_)
+            spill_.pop_back();
+        else
+            inline_[size_ - 1] = frame();
+        --size_;
+    }
+
+    void push_front(frame&& frm)
+    {
+        push_back(std::move(frm));
+        frame* first = storage();
+        for (std::size_t i = size_ - 1; i > 0; --i) std::swap(first[i], first[i - 1]);
+    }
+
+    frame pop_front()
+    {
+        frame* first = storage();
+        frame head = std::move(first[0]);
+        for (std::size_t i = 1; i < size_; ++i) first[i - 1] = std::move(first[i]);
+        pop_back();
+        return head;
+    }
+
+    // Prepends a ROUTER envelope: the routing id followed by an empty delimiter frame.
+    void push_envelope(frame&& routing_id)
+    {
+        push_front(frame());
+        push_front(std::move(routing_id));
+    }
+
+    // Removes the leading routing id and, if present, the empty delimiter that follows it.
+    frame pop_envelope()
+    {
+        frame routing_id = pop_front();
+        if (!empty() && front().size() == 0) pop_front();
+        return routing_id;
+    }
+
+    // Releases every frame but keeps any heap capacity for the next message.
+    void clear()
+    {
+        if (spilled_) {
+            spill_.clear();
+            spilled_ = false;
+        } else {
+            for (std::size_t i = 0; i < size_; ++i) inline_[i] = frame();
+        }
+        size_ = 0;
+    }
+};
+
+typedef basic_message<4> message;
+
+}  // namespace zmq
+}  // namespace asio
+}  // namespace boost
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <boost/system/error_code.hpp>
+#include "message.hpp"
+
+namespace boost {
+namespace asio {
+namespace zmq {
+
+// One notification from a socket monitor. event is one of the ZMQ_EVENT_* flags; value is the
+// file descriptor, errno or reconnect interval that goes with it, depending on the event; and
+// endpoint is the address the event concerns.
+struct monitor_event {
+    int event;
+    std::int32_t value;
+    std::string endpoint;
+
+    monitor_event() : event(0), value(0), endpoint() {}
+};
+
+namespace detail {
+
+// Decodes the two-part message libzmq sends to a monitor: a six-byte frame holding the 16-bit
+// event and the 32-bit value in host byte order, then the endpoint.
+template <std::size_t N>
+boost::system::error_code parse_monitor_event(basic_message<N> const& msg, monitor_event& event)
+{
+    if (msg.size() != 2 || msg[0].size() < 6)
+        return boost::system::errc::make_error_code(boost::system::errc::bad_message);
+
+    char const* data = static_cast<char const*>(msg[0].data());
+    std::uint16_t id;
+    std::uint32_t value;
+    std::memcpy(&id, data, sizeof(id));
+    std::memcpy(&value, data + sizeof(id), sizeof(value));
+
+    event.event = id;
+    event.value = static_cast<std::int32_t>(value);
+    event.endpoint.assign(static_cast<char const*>(msg[1].data()), msg[1].size());
+    return boost::system::error_code();
+}
+
+}  // namespace detail
+}  // namespace zmq
+}  // namespace asio
+}  // namespace boost
@@ -0,0 +1,324 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <boost/system/error_code.hpp>
+#include <zmq.h>
+#include "helpers.hpp"
+#include "device.hpp"
+#include "frame.hpp"
+#include "message.hpp"
+#include "socket.hpp"
+#include "socket_option.hpp"
+
+namespace boost {
+namespace asio {
+namespace zmq {
+
+// Message and byte counters in the order zmq_proxy_steerable reports them.
+struct proxy_statistics {
+    std::uint64_t frontend_messages_in;
+    std::uint64_t frontend_bytes_in;
+    std::uint64_t frontend_messages_out;
+    std::uint64_t frontend_bytes_out;
+    std::uint64_t backend_messages_in;
+    std::uint64_t backend_bytes_in;
+    std::uint64_t backend_messages_out;
+    std::uint64_t backend_bytes_out;
+};
+
+// Forwards messages between two sockets in both directions without copying their frames, the
+// asynchronous counterpart of zmq_proxy_steerable. Each wakeup drains up to batch_size
+// messages per direction, as many as zmq_proxy moves in one burst. A message the opposite
+// socket will not take (its high-water mark is reached) is held back, and its side is not read
+// any further until the message is accepted, so backpressure propagates instead of messages
+// being dropped.
+//
+// Every forwarded frame is also sent to the optional capture socket, where it is dropped if
+// the capture socket would block. The optional control socket accepts PAUSE, RESUME, TERMINATE
+// and STATISTICS; STATISTICS is answered with eight 64-bit frames, and a REP control socket gets
+// an empty reply to the other commands.
+//
+// All sockets must run on the same io_service, and the proxy must outlive async_run. async_run
+// completes after terminate() or a TERMINATE command.
+class proxy : public detail::basic_device<proxy, 3> {
+private:
+    friend class detail::basic_device<proxy, 3>;
+
+    using error_code = boost::system::error_code;
+    using size_t = std::size_t;
+
+    enum { frontend_index, backend_index, control_index };
+
+    // A message in flight is held in head_ while it is a single part, the common case, and in
+    // msg_ only when it has more, which saves rebuilding a message for every single-part one.
+    struct direction {
+        socket* from_;
+        socket* to_;
+        frame head_;
+        message msg_;
+        bool enabled_;
+        bool pending_;
+        bool multipart_;
+        size_t bytes_;
+        std::uint64_t* messages_in_;
+        std::uint64_t* bytes_in_;
+        std::uint64_t* messages_out_;
+        std::uint64_t* bytes_out_;
+    };
+
+    socket* capture_;
+    std::array<direction, 2> directions_;
+    proxy_statistics stats_;
+    bool control_replies_;
+    bool paused_;
+
+    // PUSH and PUB sockets cannot receive, so the direction starting at one never runs.
+    static bool can_receive(socket& sock)
+    {
+        int type = type_of(sock);
+        return type != ZMQ_PUSH && type != ZMQ_PUB;
+    }
+
+    static size_t message_bytes(message const& msg)
+    {
+        size_t bytes = 0;
+        for (auto const& frm : msg) bytes += frm.size();
+        return bytes;
+    }
+
+    void capture(frame const* first, frame const* last)
+    {
+        if (capture_ == nullptr) return;
+
+        for (frame const* it = first; it != last; ++it) {
+            // Shares the payload; only the reference count changes.
+            frame copy(*it);
+            int flag = it + 1 != last ? ZMQ_SNDMORE : 0;
+            // Once the first part is accepted the rest is too; a refused first part drops the
+            // whole message.
+            if (!capture_->try_write_frame(copy, flag)) return;
+        }
+    }
+
+    // Takes the next message off dir's source, if there is one.
+    bool receive(direction& dir)
+    {
+        if (!dir.from_->try_read_frame(dir.head_)) return false;
+
+        dir.multipart_ = dir.head_.more();
+        if (dir.multipart_) {
+            dir.msg_.clear();
+            auto buff_it = std::back_inserter(dir.msg_);
+            dir.from_->read_remaining(std::move(dir.head_), buff_it);
+            dir.bytes_ = message_bytes(dir.msg_);
+            capture(dir.msg_.begin(), dir.msg_.end());
+        } else {
+            dir.bytes_ = dir.head_.size();
+            capture(&dir.head_, &dir.head_ + 1);
+        }
+        return true;
+    }
+
+    bool send(direction& dir)
+    {
+        if (dir.multipart_) return dir.to_->try_write_message(dir.msg_.begin(), dir.msg_.end());
+        return dir.to_->try_write_frame(dir.head_, 0);
+    }
+
+    // Moves up to batch_size messages in one direction. Returns whether anything moved.
+    bool forward(direction& dir)
+    {
+        size_t count = 0;
+        while (dir.enabled_ && count < batch_size) {
+            if (!dir.pending_) {
+                if (!receive(dir)) break;
+                dir.pending_ = true;
+                *dir.messages_in_ += 1;
+                *dir.bytes_in_ += dir.bytes_;
+            }
+
+            if (!send(dir)) break;
+            dir.pending_ = false;
+            *dir.messages_out_ += 1;
+            *dir.bytes_out_ += dir.bytes_;
+            ++count;
+        }
+        return count > 0;
+    }
+
+    void reply(void const* data, size_t size, int flag)
+    {
+        frame frm(size);
+        if (size > 0) std::memcpy(frm.data(), data, size);
+        sockets_[control_index]->write_frame(frm, flag);
+    }
+
+    bool handle_control()
+    {
+        socket* control = sockets_[control_index];
+        if (control == nullptr) return false;
+
+        message cmd;
+        auto buff_it = std::back_inserter(cmd);
+        if (!control->try_read_message(buff_it)) return false;
+
+        std::string name;
+        if (!cmd.empty()) name.assign(static_cast<char const*>(cmd[0].data()), cmd[0].size());
+
+        if (name == "STATISTICS") {
+            std::uint64_t const values[] = {
+                stats_.frontend_messages_in, stats_.frontend_bytes_in,
+                stats_.frontend_messages_out, stats_.frontend_bytes_out,
+                stats_.backend_messages_in, stats_.backend_bytes_in,
+                stats_.backend_messages_out, stats_.backend_bytes_out};
+            for (size_t i = 0; i < 8; ++i)
+                reply(&values[i], sizeof(values[i]), i + 1 < 8 ? ZMQ_SNDMORE : 0);
+            return true;
+        }
+
+        if (name == "PAUSE")
+            paused_ = true;
+        else if (name == "RESUME")
+            paused_ = false;
+        else if (name == "TERMINATE")
+            terminate();
+
+        if (control_replies_) reply(nullptr, 0, 0);
+        return true;
+    }
+
+    // Whether a socket's ZMQ_EVENTS promise progress. Reading ZMQ_EVENTS also rearms the
+    // edge-triggered ZMQ_FD before the proxy waits on it.
+    bool ready()
+    {
+        bool result = sockets_[control_index] != nullptr && sockets_[control_index]->is_readable();
+        if (paused_) return result;
+
+        for (auto& dir : directions_) {
+            if (!dir.enabled_) continue;
+            if (dir.pending_)
+                result = dir.to_->is_writable() || result;
+            else
+                result = dir.from_->is_readable() || result;
+        }
+        return result;
+    }
+
+    // While nothing is held back the opposite socket's signals, from a peer reading what the
+    // proxy wrote, say nothing the proxy needs, so it waits only on the sockets it reads from
+    // and on a socket that has yet to take a held-back message. A paused proxy waits on all of
+    // them, so that any event picks up a resume().
+    bool waits_on(size_t index) const
+    {
+        socket* sock = sockets_[index];
+        if (index == control_index || paused_) return true;
+        for (auto const& dir : directions_) {
+            if (!dir.enabled_) continue;
+            if (dir.pending_ ? dir.to_ == sock : dir.from_ == sock) return true;
+        }
+        return false;
+    }
+
+    bool step()
+    {
+        bool progress = false;
+        while (!terminated() && handle_control()) progress = true;
+        if (!terminated() && !paused_) {
+            for (auto& dir : directions_) progress = forward(dir) || progress;
+        }
+        return progress;
+    }
+
+public:
+    static size_t const batch_size = 1000;
+
+    proxy(socket& frontend, socket& backend, socket* capture = nullptr, socket* control = nullptr)
+        : capture_(capture), directions_(), stats_(), control_replies_(false), paused_(false)
+    {
+        sockets_[frontend_index] = &frontend;
+        sockets_[backend_index] = &backend;
+        sockets_[control_index] = control;
+
+        direction& in = directions_[0];
+        in.from_ = &frontend;
+        in.to_ = &backend;
+        in.enabled_ = can_receive(frontend);
+        in.pending_ = false;
+        in.multipart_ = false;
+        in.bytes_ = 0;
+        in.messages_in_ = &stats_.frontend_messages_in;
+        in.bytes_in_ = &stats_.frontend_bytes_in;
+        in.messages_out_ = &stats_.backend_messages_out;
+        in.bytes_out_ = &stats_.backend_bytes_out;
+
+        direction& out = directions_[1];
+        out.from_ = &backend;
+        out.to_ = &frontend;
+        out.enabled_ = can_receive(backend);
+        out.pending_ = false;
+        out.multipart_ = false;
+        out.bytes_ = 0;
+        out.messages_in_ = &stats_.backend_messages_in;
+        out.bytes_in_ = &stats_.backend_bytes_in;
+        out.messages_out_ = &stats_.frontend_messages_out;
+        out.bytes_out_ = &stats_.frontend_bytes_out;
+
+        if (control != nullptr) control_replies_ = type_of(*control) == ZMQ_REP;
+    }
+
+    void pause() { paused_ = true; }
+
+    // Resuming from outside a handler of the proxy's sockets does not wake it; it picks up the
+    // queued messages on the next event of any of its sockets.
+    void resume() { paused_ = false; }
+
+    bool paused() const { return paused_; }
+
+    proxy_statistics statistics() const { return stats_; }
+};
+
+namespace detail {
+
+struct async_proxy_initiation {
+    socket* frontend_;
+    socket* backend_;
+    socket* capture_;
+    socket* control_;
+
+    template <typename Handler> void operator()(Handler&& handler) const
+    {
+        std::unique_ptr<proxy> p(new proxy(*frontend_, *backend_, capture_, control_));
+        run_owned_device(std::move(p), std::forward<Handler>(handler));
+    }
+};
+
+}  // namespace detail
+
+// Runs a proxy that lives until it completes: a TERMINATE command on control, or an error. The
+// handler signature is void(error_code const&).
+template <typename RunToken>
+detail::initfn_result_t<RunToken, void(boost::system::error_code)> async_proxy(
+    socket& frontend, socket& backend, socket* capture, socket* control, RunToken&& token)
+{
+    return detail::async_initiate<RunToken, void(boost::system::error_code)>(
+        detail::async_proxy_initiation{&frontend, &backend, capture, control}, token);
+}
+
+template <typename RunToken>
+detail::initfn_result_t<RunToken, void(boost::system::error_code)> async_proxy(
+    socket& frontend, socket& backend, RunToken&& token)
+{
+    return async_proxy(frontend, backend, nullptr, nullptr, std::forward<RunToken>(token));
+}
+
+}  // namespace zmq
+}  // namespace asio
+}  // namespace boost
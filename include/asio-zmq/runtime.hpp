@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include <boost/asio/io_service.hpp>
+#include "context.hpp"
+
+namespace boost {
+namespace asio {
+namespace zmq {
+
+// Runs one io_service per thread ("shard"), each thread optionally pinned to its own core, and
+// one context whose ZMQ_IO_THREADS matches the number of shards. A socket is placed on a shard
+// by constructing it with that shard's io_service; it is then only ever touched by the
+// shard's thread, so independent pipelines do not share a reactor or its locks. Sockets that
+// call each other from their handlers must be placed on the same shard.
+//
+//     runtime rt(4);
+//     socket pull(rt.shard_for(endpoint), rt.get_context(), ZMQ_PULL);
+//     socket push(rt.shard_for(endpoint), rt.get_context(), ZMQ_PUSH);
+//     ...
+//     rt.run();
+class runtime {
+private:
+    // Declared first so that it is terminated after every shard has gone.
+    context ctx_;
+    std::vector<std::unique_ptr<io_service>> shards_;
+    std::vector<std::unique_ptr<io_service::work>> work_;
+    std::vector<std::thread> threads_;
+    std::size_t next_;
+    bool pin_;
+
+    static std::size_t default_size()
+    {
+        std::size_t n = std::thread::hardware_concurrency();
+        return n > 0 ? n : 1;
+    }
+
+    static void pin_to_core(std::size_t index)
+    {
+#if defined(__linux__)
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(index % default_size(), &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#else
+        (void)index;
+#endif
+    }
+
+public:
+    // shard_count 0 means one shard per hardware thread.
+    explicit runtime(std::size_t shard_count = 0, bool pin = true)
+        : ctx_(), shards_(), work_(), threads_(), next_(0), pin_(pin)
+    {
+        if (shard_count == 0) shard_count = default_size();
+
+        ctx_.set_io_threads(static_cast<int>(shard_count));
+
+        // A concurrency hint of 1 tells Asio that each io_service is run by a single thread.
+        for (std::size_t i = 0; i < shard_count; ++i)
+            shards_.emplace_back(new io_service(1));
+    }
+
+    runtime(runtime const&) = delete;
+    runtime& operator=(runtime const&) = delete;
+
+    ~runtime() { stop(); }
+
+    context& get_context() { return ctx_; }
+
+    std::size_t size() const { return shards_.size(); }
+
+    // Explicit placement; index wraps around the number of shards.
+    io_service& shard(std::size_t index) { return *shards_[index % shards_.size()]; }
+
+    // Round-robin placement. Not thread-safe: place sockets from one thread.
+    io_service& next_shard() { return shard(next_++); }
+
+    // Places every socket that names the same endpoint on the same shard, so that both ends of
+    // an inproc pipeline share a thread.
+    io_service& shard_for(std::string const& endpoint)
+    {
+        return shard(std::hash<std::string>()(endpoint));
+    }
+
+    // Starts one thread per shard. The shards keep running, even without pending work, until
+    // join() or stop().
+    void start()
+    {
+        if (!threads_.empty()) return;
+
+        for (auto& ios : shards_) work_.emplace_back(new io_service::work(*ios));
+
+        for (std::size_t i = 0; i < shards_.size(); ++i) {
+            io_service* ios = shards_[i].get();
+            bool pin = pin_;
+            threads_.emplace_back([ios, i, pin] {
+                if (pin) pin_to_core(i);
+                ios->run();
+            });
+        }
+    }
+
+    // Lets every shard finish its outstanding work and waits for the threads to exit.
+    void join()
+    {
+        work_.clear();
+        for (auto& t : threads_) t.join();
+        threads_.clear();
+    }
+
+    // Runs all shards until every one of them is out of work.
+    void run()
+    {
+        start();
+        join();
+    }
+
+    // Abandons outstanding work and waits for the threads to exit. The shards can be started
+    // again afterwards.
+    void stop()
+    {
+        for (auto& ios : shards_) ios->stop();
+        join();
+        for (auto& ios : shards_) ios->reset();
+    }
+};
+
+}  // namespace zmq
+}  // namespace asio
+}  // namespace boost
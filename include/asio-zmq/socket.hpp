@@ -1,24 +1,61 @@
 #pragma once
 
-#include <array>
-#include <algorithm>
+#include <atomic>
+#include <cerrno>
 #include <cstddef>
+#include <iterator>
 #include <memory>
 #include <string>
+#include <type_traits>
+#include <utility>
+#include <boost/version.hpp>
+#include <boost/asio/error.hpp>
 #include <boost/asio/io_service.hpp>
 #include <boost/system/error_code.hpp>
+#if BOOST_VERSION >= 107700
+#include <boost/asio/associated_cancellation_slot.hpp>
+#include <boost/asio/cancellation_signal.hpp>
+#include <boost/asio/cancellation_type.hpp>
+#endif
 #include <zmq.h>
 #include "helpers.hpp"
+#include "deadline_service.hpp"
+#include "handler_memory.hpp"
 #include "socket_option.hpp"
 #include "context.hpp"
 #include "frame.hpp"
+#include "message.hpp"
+#include "monitor.hpp"
+#include "stats.hpp"
+#include "write_queue.hpp"
 
 namespace boost {
 namespace asio {
 namespace zmq {
 
+// How a socket invokes the handler of an operation that has finished.
+//  - post:     always queue the handler on the io_service (the default).
+//  - dispatch: run the handler immediately when called from a thread running the io_service.
+//              Nested inline completions on a thread are bounded by socket::max_inline_depth,
+//              beyond which the handler is posted so that ping-pong chains cannot exhaust the
+//              stack.
+enum class completion_mode { post, dispatch };
+
+class proxy;
+class lb_broker;
+
+namespace detail {
+template <typename Derived, std::size_t SocketCount> class basic_device;
+template <typename Handler> class device_completion_impl;
+}  // namespace detail
+
 class socket {
 private:
+    template <typename Derived, std::size_t SocketCount> friend class detail::basic_device;
+    template <typename Handler> friend class detail::device_completion_impl;
+    friend class proxy;
+    friend class lb_broker;
+
     using size_t = std::size_t;
     using string = std::string;
     using uint8_t = std::uint8_t;
@@ -28,63 +65,1032 @@ private:
     using error_code = boost::system::error_code;
 
     using socket_type = std::unique_ptr<void, socket_deleter>;
+    using time_point = deadline_service::time_point;
 
+    // Declared first so that it outlives the descriptor and any handler memory it still holds.
+    detail::handler_memory memory_;
     io_service& io_;
+    context& ctx_;
     descriptor_type descriptor_;
     socket_type zsock_;
+    completion_mode mode_;
+    // Pending asynchronous writes; writing_ is set while they are being flushed or waited for,
+    // and write_waiting_ while a wait on the descriptor is armed for them. dropped_write_waits_
+    // counts waits cancelled because the queue no longer needed them, which are still to return.
+    detail::write_queue writes_;
+    bool writing_;
+    bool write_waiting_;
+    unsigned dropped_write_waits_;
+    // Reads waiting on the descriptor, and how many of them have lost their handler to a
+    // deadline or a cancellation and only wait to be woken so that they can go away.
+    unsigned read_waits_;
+    unsigned stale_reads_;
+    // The io_service's deadline_service, looked up by the first operation with a deadline.
+    deadline_service* deadlines_;
+    // The PAIR socket receiving this socket's monitor events, created by the first
+    // async_monitor, and the message the pending one reads into.
+    std::unique_ptr<socket> monitor_;
+    message monitor_buffer_;
+    // Instrumentation; empty unless ASIO_ZMQ_ENABLE_STATS is defined. write_timing_ tracks the
+    // write queue's wait on the descriptor.
+    detail::socket_counters stats_;
+    detail::op_timing write_timing_;
 
-    template <typename OutputIt, typename HandlerPtr>
-    void read_one_message(OutputIt buff_it, HandlerPtr handler, error_code const& ec)
+    // Inline completions are counted per thread rather than per socket: it is the thread's stack
+    // they use up, and one of them may destroy the socket before the count is taken back.
+    static unsigned& inline_depth()
     {
-        if (ec) {
-            io_.post([=] { (*handler)(ec); });
-            return;
+        static thread_local unsigned depth = 0;
+        return depth;
+    }
+
+    struct inline_depth_guard {
+        unsigned& depth_;
+        explicit inline_depth_guard(unsigned& depth) : depth_(depth) { ++depth_; }
+        ~inline_depth_guard() { --depth_; }
+    };
+
+    // The user's handler of a read that may be abandoned, kept in one place while the operation
+    // moves from wait to wait. Whichever comes first, the operation finishing or its deadline or
+    // a cancellation signal on the handler's cancellation slot, takes the handler. Abandoning it
+    // completes it with timed_out or operation_aborted and the default values of the other
+    // arguments of Signature, leaving the operation stale: it returns without reading when it
+    // next wakes, so that no message is lost.
+    template <typename Handler, typename Signature> class read_state;
+
+    template <typename Handler, typename... Args>
+    class read_state<Handler, void(error_code, Args...)> : public detail::deadline_entry {
+    private:
+        socket* sock_;
+        detail::handler_memory::lifeline lifeline_;
+        deadline_service* service_;
+        Handler handler_;
+        bool abandoned_;
+#if BOOST_VERSION >= 107700
+        boost::asio::cancellation_slot slot_;
+
+        // A stale read has received nothing, so abandoning one honours every cancellation
+        // type, total included.
+        class cancellation_handler {
+        private:
+            read_state* state_;
+
+        public:
+            explicit cancellation_handler(read_state* state) : state_(state) {}
+
+            void operator()(boost::asio::cancellation_type_t type)
+            {
+                if (type != boost::asio::cancellation_type::none)
+                    state_->abandon(boost::asio::error::operation_aborted);
+            }
+        };
+#endif
+
+        static void submit(detail::deadline_entry* base, detail::deadline_expiry&& expiry)
+        {
+            std::move(expiry).submit(static_cast<read_state*>(base)->handler_);
         }
 
-        try {
-            if (is_readable()) {
-                read_message(buff_it);
-                io_.post([=] { (*handler)(error_code()); });
-            } else {
-                descriptor_.async_read_some(null_buffers(), [=](error_code const& ec, size_t) {
-                    read_one_message(buff_it, handler, ec);
-                });
+        static void expire(detail::deadline_entry* base)
+        {
+            static_cast<read_state*>(base)->abandon(boost::asio::error::timed_out);
+        }
+
+        // Neither the deadline nor the cancellation slot may call back once the handler is gone.
+        void disconnect()
+        {
+            if (service_ != nullptr) service_->cancel(*this);
+#if BOOST_VERSION >= 107700
+            if (slot_.is_connected()) slot_.clear();
+#endif
+        }
+
+        // Once the socket is gone the operation is about to be woken with operation_aborted, and
+        // completes the handler itself.
+        void abandon(error_code const& ec)
+        {
+            socket* sock = sock_;
+            disconnect();
+            if (!lifeline_.alive()) return;
+            abandoned_ = true;
+            ++sock->stale_reads_;
+            sock->reap_idle_waits();
+            sock->complete(std::move(handler_), ec, Args()...);
+        }
+
+    public:
+        read_state(socket& sock, Handler&& handler)
+            : detail::deadline_entry(&read_state::submit, &read_state::expire),
+              sock_(&sock),
+              lifeline_(sock.memory_),
+              service_(nullptr),
+              handler_(std::move(handler)),
+              abandoned_(false)
+        {
+#if BOOST_VERSION >= 107700
+            slot_ = boost::asio::get_associated_cancellation_slot(handler_);
+            if (slot_.is_connected()) slot_.template emplace<cancellation_handler>(this);
+#endif
+        }
+
+        // Only the service is touched, as a stale operation may outlive the socket.
+        ~read_state()
+        {
+            if (service_ != nullptr) service_->cancel(*this);
+        }
+
+        void set_deadline(deadline_service& service, time_point deadline)
+        {
+            service_ = &service;
+            service.schedule(*this, deadline);
+        }
+
+        // Hands back the user's handler of an operation that has finished first.
+        Handler release()
+        {
+            disconnect();
+            return std::move(handler_);
+        }
+
+        Handler& handler() { return handler_; }
+
+        bool abandoned() const { return abandoned_; }
+    };
+
+    // The handler a read operation that may be abandoned carries in place of the user's. It
+    // owns the read_state, allocated from the socket's handler_memory, carries the executor and
+    // allocator of the user's handler, and forwards the invocation hooks to it for as long as
+    // it is there. A moved-from abandonable_handler keeps pointing at the state without owning
+    // it, because memory_bound_handler moves the operation into the function it invokes before
+    // consulting the hooks.
+    template <typename Handler, typename Signature>
+    class abandonable_handler : public detail::executor_binding<Handler>,
+                                public detail::allocator_binding<Handler> {
+    private:
+        typedef read_state<Handler, Signature> state_type;
+
+        state_type* state_;
+        bool owner_;
+
+        void destroy()
+        {
+            state_->~state_type();
+            detail::handler_memory::deallocate(state_);
+            state_ = nullptr;
+            owner_ = false;
+        }
+
+    public:
+        abandonable_handler(socket& sock, Handler&& handler)
+            : detail::executor_binding<Handler>(handler),
+              detail::allocator_binding<Handler>(handler),
+              state_(static_cast<state_type*>(sock.memory_.allocate(sizeof(state_type)))),
+              owner_(true)
+        {
+            try {
+                new (state_) state_type(sock, std::move(handler));
             }
+            catch (...) {
+                detail::handler_memory::deallocate(state_);
+                throw;
+            }
+        }
+
+        abandonable_handler(abandonable_handler&& other)
+            : detail::executor_binding<Handler>(std::move(other)),
+              detail::allocator_binding<Handler>(std::move(other)),
+              state_(other.state_),
+              owner_(other.owner_)
+        {
+            other.owner_ = false;
+        }
+
+        abandonable_handler(abandonable_handler const&) = delete;
+        abandonable_handler& operator=(abandonable_handler const&) = delete;
+
+        ~abandonable_handler()
+        {
+            if (owner_) destroy();
+        }
+
+        void set_deadline(socket& sock, time_point deadline)
+        {
+            state_->set_deadline(sock.deadlines(), deadline);
         }
-        catch (exception const& e) {
-            auto code = e.get_code();
-            io_.post([=] { (*handler)(code); });
+
+        bool abandoned() const { return state_->abandoned(); }
+
+        // Hands back the user's handler; not for an abandoned operation.
+        Handler release()
+        {
+            Handler handler(state_->release());
+            destroy();
+            return handler;
+        }
+
+        template <typename Function>
+        friend void asio_handler_invoke(Function& func, abandonable_handler* self)
+        {
+            if (self->state_->abandoned())
+                func();
+            else
+                boost_asio_handler_invoke_helpers::invoke(func, self->state_->handler());
         }
+
+        template <typename Function>
+        friend void asio_handler_invoke(Function const& func, abandonable_handler* self)
+        {
+            Function tmp(func);
+            asio_handler_invoke(tmp, self);
+        }
+
+        friend bool asio_handler_is_continuation(abandonable_handler* self)
+        {
+            return !self->state_->abandoned() &&
+                   boost_asio_handler_cont_helpers::is_continuation(self->state_->handler());
+        }
+    };
+
+    template <typename Handler, typename... Args>
+    void complete(Handler&& handler, Args const&... args)
+    {
+        complete_from(detail::stats_stamp(), std::move(handler), args...);
+    }
+
+    // As complete(), for an operation that became ready at ready.
+    template <typename Handler, typename... Args>
+    void complete_from(detail::stats_stamp const& ready, Handler&& handler, Args const&... args)
+    {
+        typedef typename std::decay<decltype(detail::time_handler(
+            std::move(handler), stats_, memory_, ready))>::type handler_type;
+        detail::completion_handler<handler_type, Args...> func(
+            memory_, detail::time_handler(std::move(handler), stats_, memory_, ready), args...);
+
+        unsigned& depth = inline_depth();
+        if (mode_ == completion_mode::dispatch && depth < max_inline_depth) {
+            inline_depth_guard guard(depth);
+            detail::dispatch(io_, std::move(func));
+        } else {
+            detail::post(io_, std::move(func));
+        }
+    }
+
+    // An operation that finishes before it is abandoned takes its handler back, cancelling its
+    // deadline and disconnecting it from its cancellation slot.
+    template <typename Handler, typename Signature, typename... Args>
+    void complete_from(detail::stats_stamp const& ready,
+                       abandonable_handler<Handler, Signature>&& handler, Args const&... args)
+    {
+        complete_from(ready, handler.release(), args...);
+    }
+
+    // Completes the handler of an operation woken after the socket was destroyed. There is no
+    // socket left to complete it through, so it is invoked directly; the operation already runs
+    // inside the handler's invocation hooks.
+    template <typename Handler, typename... Args>
+    static void complete_orphaned(Handler& handler, Args const&... args)
+    {
+        Handler tmp(std::move(handler));
+        tmp(args...);
+    }
+
+    // An abandoned operation has completed its handler already.
+    template <typename Handler, typename Signature, typename... Args>
+    static void complete_orphaned(abandonable_handler<Handler, Signature>& handler,
+                                  Args const&... args)
+    {
+        if (handler.abandoned()) return;
+        Handler tmp(handler.release());
+        tmp(args...);
+    }
+
+    deadline_service& deadlines()
+    {
+        if (deadlines_ == nullptr) deadlines_ = &boost::asio::use_service<deadline_service>(io_);
+        return *deadlines_;
+    }
+
+    // Bracket every wait of a read operation on the descriptor. end_read_wait returns false when
+    // the operation has gone stale while waiting and must return without reading.
+    template <typename Handler> void begin_read_wait(Handler const&) { ++read_waits_; }
+
+    template <typename Handler> bool end_read_wait(Handler const&)
+    {
+        --read_waits_;
+        return true;
     }
 
-    template <typename InputIt, typename HandlerPtr>
-    void write_one_message(InputIt first_it, InputIt last_it, HandlerPtr handler,
-                           error_code const& ec)
+    template <typename Handler, typename Signature>
+    bool end_read_wait(abandonable_handler<Handler, Signature> const& handler)
     {
-        if (ec) {
-            io_.post([=] { (*handler)(ec); });
+        --read_waits_;
+        if (!handler.abandoned()) return true;
+        --stale_reads_;
+        return false;
+    }
+
+    // A stale read is normally woken, and freed, by the next message, and so is a write wait
+    // whose queue has emptied without it, its writes having timed out or been cancelled. Once
+    // every wait on the descriptor is of that kind, cancelling the descriptor frees them at
+    // once, so that a loop of operations timing out or cancelled on a quiet socket does not
+    // pile them up, and the io_service can run out of work.
+    void reap_idle_waits()
+    {
+        bool idle_write_wait = write_waiting_ && writes_.empty();
+        // The next write is to be tried at once, not left to the idle wait.
+        if (idle_write_wait) writing_ = false;
+        if (stale_reads_ != read_waits_ || (write_waiting_ && !idle_write_wait)) return;
+        if (idle_write_wait) {
+            write_waiting_ = false;
+            ++dropped_write_waits_;
+        }
+        else if (read_waits_ == 0) {
             return;
         }
+        descriptor_.cancel();
+    }
+
+    // Waits for ZMQ_FD to signal on behalf of a read operation. Asio runs the operation on the
+    // executor of the user's handler, unless that runs on the io_service anyway.
+    template <typename Op> void wait_readable(Op&& op)
+    {
+#if BOOST_VERSION >= 106600
+        wait_readable(std::move(op), detail::has_executor<Op>());
+#else
+        descriptor_.async_read_some(null_buffers(), std::move(op));
+#endif
+    }
+
+#if BOOST_VERSION >= 106600
+    template <typename Op> void wait_readable(Op&& op, std::false_type)
+    {
+        descriptor_.async_read_some(null_buffers(), std::move(op));
+    }
+
+    template <typename Op> void wait_readable(Op&& op, std::true_type)
+    {
+        if (detail::runs_on(boost::asio::get_associated_executor(op), io_))
+            descriptor_.async_read_some(null_buffers(), detail::unbound_handler<Op>(std::move(op)));
+        else
+            descriptor_.async_read_some(null_buffers(), std::move(op));
+    }
+#endif
+
+    template <typename Handler, typename OutputIt>
+    class read_message_op : public detail::memory_bound_handler<Handler> {
+    private:
+        socket* sock_;
+        detail::handler_memory::lifeline lifeline_;
+        OutputIt buff_it_;
+        detail::op_timing timing_;
+        bool waiting_;
+
+    public:
+        read_message_op(socket& sock, Handler&& handler, OutputIt buff_it)
+            : detail::memory_bound_handler<Handler>(sock.memory_, std::move(handler)),
+              sock_(&sock),
+              lifeline_(sock.memory_),
+              buff_it_(buff_it),
+              timing_(),
+              waiting_(false)
+        {
+        }
+
+        void operator()(error_code const& ec, size_t = 0)
+        {
+            if (waiting_) {
+                waiting_ = false;
+                if (!lifeline_.alive()) {
+                    complete_orphaned(this->handler_,
+                                      error_code(boost::asio::error::operation_aborted));
+                    return;
+                }
+                if (!sock_->end_read_wait(this->handler_)) return;
+            }
+            if (ec) {
+                sock_->complete(std::move(this->handler_), ec);
+                return;
+            }
+
+            timing_.resume(sock_->stats_);
+            try {
+                // ZMQ_EVENTS is only consulted when the non-blocking receive comes back empty;
+                // it also rearms the edge-triggered ZMQ_FD before waiting on it.
+                while (!sock_->try_read_message(buff_it_)) {
+                    if (!sock_->is_readable()) {
+                        timing_.wait(sock_->stats_);
+                        waiting_ = true;
+                        sock_->begin_read_wait(this->handler_);
+                        sock_->wait_readable(std::move(*this));
+                        return;
+                    }
+                }
+                sock_->complete_from(timing_.ready(), std::move(this->handler_), error_code());
+            }
+            catch (exception const& e) {
+                sock_->complete(std::move(this->handler_), e.get_code());
+            }
+        }
+    };
+
+    template <typename Handler, typename MessageContainer>
+    class read_messages_op : public detail::memory_bound_handler<Handler> {
+    private:
+        socket* sock_;
+        detail::handler_memory::lifeline lifeline_;
+        MessageContainer* buff_;
+        size_t max_batch_;
+        detail::op_timing timing_;
+        bool waiting_;
+
+    public:
+        read_messages_op(socket& sock, Handler&& handler, MessageContainer* buff,
+                         size_t max_batch)
+            : detail::memory_bound_handler<Handler>(sock.memory_, std::move(handler)),
+              sock_(&sock),
+              lifeline_(sock.memory_),
+              buff_(buff),
+              max_batch_(max_batch),
+              timing_(),
+              waiting_(false)
+        {
+        }
+
+        void operator()(error_code const& ec, size_t = 0)
+        {
+            if (waiting_) {
+                waiting_ = false;
+                if (!lifeline_.alive()) {
+                    complete_orphaned(this->handler_,
+                                      error_code(boost::asio::error::operation_aborted), size_t(0));
+                    return;
+                }
+                if (!sock_->end_read_wait(this->handler_)) return;
+            }
+            if (ec) {
+                sock_->complete(std::move(this->handler_), ec, size_t(0));
+                return;
+            }
+
+            timing_.resume(sock_->stats_);
+            size_t count = 0;
+            try {
+                while (max_batch_ > 0 &&
+                       sock_->read_available_messages(*buff_, max_batch_, count) == 0) {
+                    if (!sock_->is_readable()) {
+                        timing_.wait(sock_->stats_);
+                        waiting_ = true;
+                        sock_->begin_read_wait(this->handler_);
+                        sock_->wait_readable(std::move(*this));
+                        return;
+                    }
+                }
+                sock_->complete_from(timing_.ready(), std::move(this->handler_), error_code(),
+                                     count);
+            }
+            catch (exception const& e) {
+                sock_->complete(std::move(this->handler_), e.get_code(), count);
+            }
+        }
+    };
+
+    template <typename Handler>
+    class read_frame_op : public detail::memory_bound_handler<Handler> {
+    private:
+        socket* sock_;
+        detail::handler_memory::lifeline lifeline_;
+        frame* frm_;
+        detail::op_timing timing_;
+        bool waiting_;
+
+    public:
+        read_frame_op(socket& sock, Handler&& handler, frame* frm)
+            : detail::memory_bound_handler<Handler>(sock.memory_, std::move(handler)),
+              sock_(&sock),
+              lifeline_(sock.memory_),
+              frm_(frm),
+              timing_(),
+              waiting_(false)
+        {
+        }
+
+        void operator()(error_code const& ec, size_t = 0)
+        {
+            if (waiting_) {
+                waiting_ = false;
+                if (!lifeline_.alive()) {
+                    complete_orphaned(this->handler_,
+                                      error_code(boost::asio::error::operation_aborted), false);
+                    return;
+                }
+                if (!sock_->end_read_wait(this->handler_)) return;
+            }
+            if (ec) {
+                sock_->complete(std::move(this->handler_), ec, false);
+                return;
+            }
+
+            timing_.resume(sock_->stats_);
+            try {
+                while (!sock_->try_read_frame(*frm_)) {
+                    if (!sock_->is_readable()) {
+                        timing_.wait(sock_->stats_);
+                        waiting_ = true;
+                        sock_->begin_read_wait(this->handler_);
+                        sock_->wait_readable(std::move(*this));
+                        return;
+                    }
+                }
+                sock_->complete_from(timing_.ready(), std::move(this->handler_), error_code(),
+                                     frm_->more());
+            }
+            catch (exception const& e) {
+                sock_->complete(std::move(this->handler_), e.get_code(), false);
+            }
+        }
+    };
+
+    // A queued write that owns the user's handler, and holds work on the handler's executor
+    // until the handler has been submitted to it. Its memory comes from the socket's
+    // handler_memory and is released before the handler is completed. A write whose deadline
+    // passes, or whose handler's cancellation slot is signalled, while it is still queued leaves
+    // the queue and completes with timed_out or operation_aborted.
+    template <typename Handler, typename Payload>
+    class queued_write_op : public detail::write_op, public detail::deadline_entry {
+    private:
+        socket* sock_;
+        Payload payload_;
+        Handler handler_;
+        detail::handler_work<Handler> work_;
+        deadline_service* deadlines_;
+#if BOOST_VERSION >= 107700
+        boost::asio::cancellation_slot slot_;
+
+        // A queued write has not handed ZeroMQ any part of its message, so taking it out of
+        // the queue honours every cancellation type, total included.
+        class cancellation_handler {
+        private:
+            queued_write_op* op_;
+
+        public:
+            explicit cancellation_handler(queued_write_op* op) : op_(op) {}
+
+            void operator()(boost::asio::cancellation_type_t type)
+            {
+                if (type != boost::asio::cancellation_type::none)
+                    abandon(op_, boost::asio::error::operation_aborted);
+            }
+        };
+#endif
+
+        void disconnect()
+        {
+            if (deadlines_ != nullptr) deadlines_->cancel(*this);
+#if BOOST_VERSION >= 107700
+            if (slot_.is_connected()) slot_.clear();
+#endif
+        }
+
+        static void abandon(queued_write_op* op, error_code const& ec)
+        {
+            socket* sock = op->sock_;
+            sock->writes_.erase(op);
+            op->disconnect();
+            Handler handler(std::move(op->handler_));
+            detail::handler_work<Handler> work(std::move(op->work_));
+            op->~queued_write_op();
+            detail::handler_memory::deallocate(op);
+            sock->reap_idle_waits();
+            sock->complete(std::move(handler), ec);
+        }
+
+        static bool do_perform(detail::write_op* base)
+        {
+            queued_write_op* op = static_cast<queued_write_op*>(base);
+            return op->payload_.try_write(*op->sock_);
+        }
+
+        static void do_complete(detail::write_op* base, error_code const* ec)
+        {
+            queued_write_op* op = static_cast<queued_write_op*>(base);
+            socket* sock = op->sock_;
+            op->disconnect();
+            Handler handler(std::move(op->handler_));
+            detail::handler_work<Handler> work(std::move(op->work_));
+            op->~queued_write_op();
+            detail::handler_memory::deallocate(op);
+            if (ec != nullptr)
+                sock->complete_from(sock->write_timing_.ready(), std::move(handler), *ec);
+        }
+
+        static void do_submit(detail::deadline_entry* base, detail::deadline_expiry&& expiry)
+        {
+            std::move(expiry).submit(static_cast<queued_write_op*>(base)->handler_);
+        }
+
+        static void do_expire(detail::deadline_entry* base)
+        {
+            abandon(static_cast<queued_write_op*>(base), boost::asio::error::timed_out);
+        }
+
+    public:
+        queued_write_op(socket& sock, Handler&& handler, Payload&& payload)
+            : detail::write_op(&queued_write_op::do_perform, &queued_write_op::do_complete),
+              detail::deadline_entry(&queued_write_op::do_submit, &queued_write_op::do_expire),
+              sock_(&sock),
+              payload_(std::move(payload)),
+              handler_(std::move(handler)),
+              work_(handler_, sock.io_),
+              deadlines_(nullptr)
+        {
+#if BOOST_VERSION >= 107700
+            slot_ = boost::asio::get_associated_cancellation_slot(handler_);
+            if (slot_.is_connected()) slot_.template emplace<cancellation_handler>(this);
+#endif
+        }
+
+        void set_deadline(deadline_service& deadlines, time_point deadline)
+        {
+            deadlines_ = &deadlines;
+            deadlines.schedule(*this, deadline);
+        }
+    };
+
+    template <typename InputIt> struct message_payload {
+        InputIt first_it_;
+        InputIt last_it_;
+
+        bool try_write(socket& sock) { return sock.try_write_message(first_it_, last_it_); }
+    };
+
+    struct frame_payload {
+        frame frm_;
+        int flag_;
+
+        bool try_write(socket& sock) { return sock.try_write_frame(frm_, flag_); }
+    };
+
+    // Resumes the write queue once the descriptor reports that ZeroMQ may accept more. There
+    // is at most one of these outstanding per socket, whatever the length of the queue.
+    class write_ready_handler {
+    private:
+        socket* sock_;
+        detail::handler_memory* memory_;
+        detail::handler_memory::lifeline lifeline_;
+
+    public:
+        typedef detail::recycling_allocator<void> allocator_type;
+
+        explicit write_ready_handler(socket& sock)
+            : sock_(&sock), memory_(&sock.memory_), lifeline_(sock.memory_)
+        {
+        }
 
+        allocator_type get_allocator() const noexcept { return allocator_type(*memory_); }
+
+        // The queue of a destroyed socket was destroyed with it.
+        void operator()(error_code const& ec, size_t = 0)
+        {
+            if (!lifeline_.alive()) return;
+            if (sock_->dropped_write_waits_ > 0) {
+                --sock_->dropped_write_waits_;
+                return;
+            }
+            sock_->write_waiting_ = false;
+            if (ec) {
+                sock_->fail_writes(ec);
+                return;
+            }
+            sock_->write_timing_.resume(sock_->stats_);
+            sock_->flush_writes();
+        }
+
+        friend void* asio_handler_allocate(std::size_t size, write_ready_handler* self)
+        {
+            return self->memory_->allocate(size);
+        }
+
+        friend void asio_handler_deallocate(void* p, std::size_t, write_ready_handler*)
+        {
+            detail::handler_memory::deallocate(p);
+        }
+    };
+
+    template <typename Payload, typename Handler, typename... Args>
+    queued_write_op<Handler, Payload>* new_write(Handler&& handler, Args&&... args)
+    {
+        typedef queued_write_op<Handler, Payload> op_type;
+
+        void* p = memory_.allocate(sizeof(op_type));
         try {
-            if (is_writable()) {
-                write_message(first_it, last_it);
-                io_.post([=] { (*handler)(error_code()); });
-            } else {
-                descriptor_.async_write_some(null_buffers(), [=](error_code const& ec, size_t) {
-                    write_one_message(first_it, last_it, handler, ec);
-                });
+            return new (p) op_type(*this, std::move(handler), Payload{std::forward<Args>(args)...});
+        }
+        catch (...) {
+            detail::handler_memory::deallocate(p);
+            throw;
+        }
+    }
+
+    // Creates the queued write for a handler produced by async_initiate and appends it.
+    template <typename Payload> struct write_initiation {
+        socket* sock_;
+
+        template <typename Handler, typename... Args>
+        void operator()(Handler&& handler, Args&&... args) const
+        {
+            typedef typename std::decay<Handler>::type handler_type;
+            sock_->enqueue_write(sock_->new_write<Payload>(
+                handler_type(std::forward<Handler>(handler)), std::forward<Args>(args)...));
+        }
+    };
+
+    // As write_initiation, for a write that is to give up at deadline.
+    template <typename Payload> struct deadline_write_initiation {
+        socket* sock_;
+
+        template <typename Handler, typename... Args>
+        void operator()(Handler&& handler, time_point deadline, Args&&... args) const
+        {
+            typedef typename std::decay<Handler>::type handler_type;
+            auto op = sock_->new_write<Payload>(handler_type(std::forward<Handler>(handler)),
+                                                std::forward<Args>(args)...);
+            op->set_deadline(sock_->deadlines(), deadline);
+            sock_->enqueue_write(op);
+        }
+    };
+
+    void enqueue_write(detail::write_op* op)
+    {
+        bool idle = !writing_;
+        writes_.push(op);
+        if (idle) {
+            write_timing_ = detail::op_timing();
+            flush_writes();
+        }
+    }
+
+    // Hands queued writes to ZeroMQ in order until the queue is empty or the socket would
+    // block, in which case one wait on the descriptor is armed for the whole queue, unless one
+    // already is. ZMQ_FD only ever signals readable, whichever way ZMQ_EVENTS changed, and is
+    // always writable, so the wait is a read wait; waiting for writability would wake at once,
+    // over and over, for as long as the socket stays full. A write that would block while
+    // ZMQ_EVENTS reports room is retried once, as reading ZMQ_EVENTS may have let ZeroMQ take in
+    // pending commands, and then waits too: a ROUTER with ZMQ_ROUTER_MANDATORY reports room while
+    // the pipe to the peer the write is for is full. Handlers completed inline may queue further
+    // writes, which are picked up by the same loop, or destroy the socket, which ends it.
+    void flush_writes()
+    {
+        detail::handler_memory::lifeline lifeline(memory_);
+        writing_ = true;
+        bool progress = false;
+        bool retried = false;
+        while (detail::write_op* op = writes_.front()) {
+            error_code ec;
+            try {
+                if (!op->perform()) {
+                    // ZMQ_EVENTS is read before every wait, which rearms ZMQ_FD.
+                    if (is_writable() && !retried) {
+                        retried = true;
+                        continue;
+                    }
+                    if (!write_waiting_) {
+                        write_timing_.wait(stats_, progress);
+                        write_waiting_ = true;
+                        descriptor_.async_read_some(null_buffers(), write_ready_handler(*this));
+                    }
+                    return;
+                }
+            }
+            catch (exception const& e) {
+                ec = e.get_code();
+            }
+            writes_.pop();
+            progress = true;
+            retried = false;
+            op->complete(ec);
+            if (!lifeline.alive()) return;
+        }
+        writing_ = false;
+    }
+
+    // ZeroMQ signals ZMQ_FD for changes made by its I/O threads and the socket's peers, but not
+    // for those the socket's own calls make at once, such as an inproc connect attaching its
+    // pipe. A write queue waiting for room has to look again after such a call; the wait it
+    // leaves armed goes once it is idle.
+    void wake_writes()
+    {
+        if (!write_waiting_ || !is_writable()) return;
+        detail::handler_memory::lifeline lifeline(memory_);
+        flush_writes();
+        if (lifeline.alive()) reap_idle_waits();
+    }
+
+    void fail_writes(error_code const& ec)
+    {
+        detail::handler_memory::lifeline lifeline(memory_);
+        while (detail::write_op* op = writes_.front()) {
+            writes_.pop();
+            op->complete(ec);
+            if (!lifeline.alive()) return;
+        }
+        writing_ = false;
+    }
+
+    // Starts a read, Op<Handler, Params...>, once async_initiate has turned the token into a
+    // handler. A handler whose cancellation slot is connected, as that of a coroutine or of an
+    // operation in a parallel_group is, comes wrapped in an abandonable_handler for Signature so
+    // that a cancellation signal abandons this read alone.
+    template <typename Signature, template <typename, typename...> class Op, typename... Params>
+    struct initiation {
+        socket* sock_;
+
+        template <typename Handler, typename... Args>
+        void operator()(Handler&& handler, Args&&... args) const
+        {
+            typedef typename std::decay<Handler>::type handler_type;
+#if BOOST_VERSION >= 107700
+            if (boost::asio::get_associated_cancellation_slot(handler).is_connected()) {
+                typedef abandonable_handler<handler_type, Signature> abandonable_type;
+                Op<abandonable_type, Params...>(
+                    *sock_, abandonable_type(*sock_, handler_type(std::forward<Handler>(handler))),
+                    std::forward<Args>(args)...)(error_code());
+                return;
             }
+#endif
+            Op<handler_type, Params...>(*sock_, handler_type(std::forward<Handler>(handler)),
+                                        std::forward<Args>(args)...)(error_code());
+        }
+    };
+
+    // As initiation, for a read with a deadline.
+    template <typename Signature, template <typename, typename...> class Op, typename... Params>
+    struct deadline_initiation {
+        socket* sock_;
+
+        template <typename Handler, typename... Args>
+        void operator()(Handler&& handler, time_point deadline, Args&&... args) const
+        {
+            typedef typename std::decay<Handler>::type user_handler_type;
+            typedef abandonable_handler<user_handler_type, Signature> handler_type;
+            handler_type abandonable(*sock_, user_handler_type(std::forward<Handler>(handler)));
+            abandonable.set_deadline(*sock_, deadline);
+            Op<handler_type, Params...>(*sock_, std::move(abandonable),
+                                        std::forward<Args>(args)...)(error_code());
         }
-        catch (exception const& e) {
-            auto code = e.get_code();
-            io_.post([=] { (*handler)(code); });
+    };
+
+    // Completes an async_monitor once the monitor socket has received the event message.
+    template <typename Handler> class monitor_op : public detail::memory_bound_handler<Handler> {
+    private:
+        socket* sock_;
+        detail::handler_memory::lifeline lifeline_;
+
+    public:
+        monitor_op(socket& sock, Handler&& handler)
+            : detail::memory_bound_handler<Handler>(sock.memory_, std::move(handler)),
+              sock_(&sock),
+              lifeline_(sock.memory_)
+        {
+        }
+
+        void operator()(error_code const& ec)
+        {
+            if (!lifeline_.alive()) {
+                complete_orphaned(this->handler_, error_code(boost::asio::error::operation_aborted),
+                                  monitor_event());
+                return;
+            }
+            monitor_event event;
+            error_code result = ec;
+            if (!result) result = detail::parse_monitor_event(sock_->monitor_buffer_, event);
+            sock_->complete(std::move(this->handler_), result, event);
         }
+    };
+
+    struct monitor_initiation {
+        socket* sock_;
+
+        template <typename Handler> void operator()(Handler&& handler, int events) const
+        {
+            typedef typename std::decay<Handler>::type handler_type;
+            try {
+                sock_->start_monitor(events);
+            }
+            catch (exception const& e) {
+                sock_->complete(handler_type(std::forward<Handler>(handler)), e.get_code(),
+                                monitor_event());
+                return;
+            }
+            sock_->monitor_->async_read_message(
+                sock_->monitor_buffer_,
+                monitor_op<handler_type>(*sock_, handler_type(std::forward<Handler>(handler))));
+        }
+    };
+
+    void start_monitor(int events)
+    {
+        if (monitor_) return;
+
+        static std::atomic<unsigned long> counter(0);
+        string endpoint = "inproc://asio-zmq.monitor." + std::to_string(counter++);
+        if (-1 == zmq_socket_monitor(zsock_.get(), endpoint.c_str(), events)) throw exception();
+
+        std::unique_ptr<socket> monitor(new socket(io_, ctx_, ZMQ_PAIR));
+        monitor->connect(endpoint);
+        monitor_ = std::move(monitor);
+    }
+
+    bool try_read_frame(frame& frm)
+    {
+        if (-1 != zmq_msg_recv(&frm.raw_msg_, zsock_.get(), ZMQ_DONTWAIT)) {
+            stats_.frame_received(frm);
+            return true;
+        }
+        if (zmq_errno() != EAGAIN) throw exception();
+        stats_.would_block();
+        return false;
+    }
+
+    bool try_write_frame(frame const& frm, int flag)
+    {
+        int rc = zmq_msg_send(const_cast<zmq_msg_t*>(&frm.raw_msg_), zsock_.get(),
+                              flag | ZMQ_DONTWAIT);
+        if (rc != -1) {
+            stats_.frame_sent(rc, (flag & ZMQ_SNDMORE) != 0);
+            return true;
+        }
+        if (zmq_errno() != EAGAIN) throw exception();
+        stats_.would_block();
+        return false;
+    }
+
+    // Stores head and the remaining parts of its message. ZeroMQ delivers a multipart message
+    // atomically, so once the first part has arrived the others are read without waiting.
+    template <typename OutputIt> void read_remaining(frame&& head, OutputIt& buff_it)
+    {
+        bool more = head.more();
+        *buff_it++ = std::move(head);
+        while (more) {
+            frame tmp = read_frame();
+            more = tmp.more();
+            *buff_it++ = std::move(tmp);
+        }
+    }
+
+    template <typename OutputIt> bool try_read_message(OutputIt& buff_it)
+    {
+        frame head;
+        if (!try_read_frame(head)) return false;
+        read_remaining(std::move(head), buff_it);
+        return true;
+    }
+
+    // Once the first part of a message is accepted the socket accepts the rest as well.
+    template <typename InputIt> bool try_write_message(InputIt first_it, InputIt last_it)
+    {
+        if (first_it == last_it) return true;
+
+        InputIt next = first_it;
+        if (!try_write_frame(*first_it, ++next != last_it ? ZMQ_SNDMORE : 0)) return false;
+        write_message(next, last_it);
+        return true;
+    }
+
+    // Appends up to max_batch complete messages that are already queued on the socket without
+    // blocking. The running total is kept in count so that it survives an exception.
+    template <typename MessageContainer>
+    size_t read_available_messages(MessageContainer& buff, size_t max_batch, size_t& count)
+    {
+        size_t const first = count;
+        frame head;
+        while (count < max_batch && try_read_frame(head)) {
+            buff.emplace_back();
+            auto buff_it = std::back_inserter(buff.back());
+            read_remaining(std::move(head), buff_it);
+            ++count;
+        }
+        return count - first;
     }
 
 public:
+    static unsigned const max_inline_depth = 16;
+
     explicit socket(io_service& io, context& ctx, int type)
-        : io_(io), descriptor_(io), zsock_(::zmq_socket(ctx.zctx_.get(), type))
+        : memory_(),
+          io_(io),
+          ctx_(ctx),
+          descriptor_(io),
+          zsock_(::zmq_socket(ctx.zctx_.get(), type)),
+          mode_(completion_mode::post),
+          writes_(),
+          writing_(false),
+          write_waiting_(false),
+          dropped_write_waits_(0),
+          read_waits_(0),
+          stale_reads_(0),
+          deadlines_(nullptr),
+          monitor_(),
+          monitor_buffer_()
     {
         if (!zsock_) {
             throw exception();
@@ -95,16 +1101,41 @@ public:
         descriptor_.assign(fd.value());
     }
 
-    void cancel() { descriptor_.cancel(); }
+    // Pending reads are aborted by the release of the descriptor and queued writes complete
+    // with operation_aborted here, so that every operation completes once. Their handlers are
+    // posted, never run inside the destructor.
+    ~socket()
+    {
+        mode_ = completion_mode::post;
+        fail_writes(boost::asio::error::operation_aborted);
+    }
+
+    // Counters and latency histograms of this socket; all zero unless the library is built
+    // with ASIO_ZMQ_ENABLE_STATS. Safe to call from any thread.
+    socket_stats stats() const { return stats_.snapshot(); }
+
+    // Aborts every pending read, the whole write queue and a pending async_monitor. To give up
+    // on one operation only, signal the cancellation slot of its handler instead.
+    void cancel()
+    {
+        descriptor_.cancel();
+        if (monitor_) monitor_->cancel();
+    }
+
+    completion_mode get_completion_mode() const { return mode_; }
+
+    void set_completion_mode(completion_mode mode) { mode_ = mode; }
 
     void bind(string const& endpoint)
     {
         if (0 != zmq_bind(zsock_.get(), endpoint.c_str())) throw exception();
+        wake_writes();
     }
 
     void connect(string const& endpoint)
     {
         if (0 != zmq_connect(zsock_.get(), endpoint.c_str())) throw exception();
+        wake_writes();
     }
 
     bool is_readable() const
@@ -132,24 +1163,38 @@ public:
     {
         frame tmp;
         if (-1 == zmq_msg_recv(&tmp.raw_msg_, zsock_.get(), flag)) throw exception();
+        stats_.frame_received(tmp);
         return tmp;
     }
 
     void write_frame(frame const& frm, int flag = 0)
     {
-        if (-1 == zmq_msg_send(const_cast<zmq_msg_t*>(&frm.raw_msg_), zsock_.get(), flag))
-            throw exception();
+        int rc = zmq_msg_send(const_cast<zmq_msg_t*>(&frm.raw_msg_), zsock_.get(), flag);
+        if (rc == -1) throw exception();
+        stats_.frame_sent(rc, (flag & ZMQ_SNDMORE) != 0);
     }
 
     template <typename OutputIt> void read_message(OutputIt buff_it)
     {
-        do {
-            *buff_it++ = read_frame();
-        } while (has_more());
+        read_remaining(read_frame(), buff_it);
+    }
+
+    // Replaces the contents of msg with the next message.
+    template <std::size_t N> void read_message(basic_message<N>& msg)
+    {
+        msg.clear();
+        read_message(std::back_inserter(msg));
+    }
+
+    template <std::size_t N> void write_message(basic_message<N> const& msg)
+    {
+        write_message(msg.begin(), msg.end());
     }
 
     template <typename InputIt> void write_message(InputIt first_it, InputIt last_it)
     {
+        if (first_it == last_it) return;
+
         InputIt prev = first_it;
         InputIt curr = first_it;
 
@@ -160,22 +1205,194 @@ public:
         if (prev != last_it) write_frame(*prev);
     }
 
-    template <typename OutputIt, typename ReadHandler>
-    void async_read_message(OutputIt buff_it, ReadHandler handler)
+    // Blocks until at least one message arrives, then appends every further message that is
+    // already queued, up to max_batch in total. Returns the number of messages appended.
+    template <typename MessageContainer>
+    size_t read_messages(MessageContainer& buff, size_t max_batch)
+    {
+        if (max_batch == 0) return 0;
+
+        buff.emplace_back();
+        read_message(std::back_inserter(buff.back()));
+
+        size_t count = 1;
+        read_available_messages(buff, max_batch, count);
+        return count;
+    }
+
+    // Every asynchronous operation accepts any Asio completion token: a plain callback,
+    // use_future, yield_context or, with C++20 coroutines, use_awaitable.
+    //
+    // With Boost 1.77 or later the reads and writes also support per-operation cancellation
+    // through the cancellation slot associated with their handler, of any cancellation type.
+    // A signalled read that has received nothing, or write still in the queue, completes with
+    // boost::asio::error::operation_aborted and has no other effect: the next message is left
+    // for a later read and other writes keep flowing. This is what lets a read take part in a
+    // parallel_group or an awaitable_operators race against a timer without touching the rest
+    // of the socket.
+    template <typename OutputIt, typename ReadToken>
+    detail::initfn_result_t<ReadToken, void(error_code)> async_read_message(OutputIt buff_it,
+                                                                            ReadToken&& token)
+    {
+        return detail::async_initiate<ReadToken, void(error_code)>(
+            initiation<void(error_code), read_message_op, OutputIt>{this}, token, buff_it);
+    }
+
+    // Replaces the contents of msg with the next message; msg must outlive the operation.
+    template <std::size_t N, typename ReadToken>
+    detail::initfn_result_t<ReadToken, void(error_code)> async_read_message(
+        basic_message<N>& msg, ReadToken&& token)
+    {
+        msg.clear();
+        return async_read_message(std::back_inserter(msg), std::forward<ReadToken>(token));
+    }
+
+    // msg must outlive the operation.
+    template <std::size_t N, typename WriteToken>
+    detail::initfn_result_t<WriteToken, void(error_code)> async_write_message(
+        basic_message<N> const& msg, WriteToken&& token)
     {
-        read_one_message(buff_it, std::make_shared<ReadHandler>(handler), error_code());
+        return async_write_message(msg.begin(), msg.end(), std::forward<WriteToken>(token));
     }
 
-    template <typename InputIt, typename WriteHandler>
-    void async_write_message(InputIt first_it, InputIt last_it, WriteHandler handler)
+    // Asynchronous writes go through a per-socket queue: any number may be outstanding, their
+    // messages reach ZeroMQ whole and in the order the writes were started, and their handlers
+    // complete in that order. Synchronous writes bypass the queue and must not be mixed in.
+    template <typename InputIt, typename WriteToken>
+    detail::initfn_result_t<WriteToken, void(error_code)> async_write_message(
+        InputIt first_it, InputIt last_it, WriteToken&& token)
     {
-        write_one_message(first_it, last_it, std::make_shared<WriteHandler>(handler), error_code());
+        return detail::async_initiate<WriteToken, void(error_code)>(
+            write_initiation<message_payload<InputIt>>{this}, token, first_it, last_it);
+    }
+
+    // Receives a single frame into frm, which must outlive the operation. The handler signature
+    // is void(error_code const&, bool more), where more tells whether further parts of the same
+    // message follow.
+    template <typename ReadToken>
+    detail::initfn_result_t<ReadToken, void(error_code, bool)> async_read_frame(
+        frame& frm, ReadToken&& token)
+    {
+        return detail::async_initiate<ReadToken, void(error_code, bool)>(
+            initiation<void(error_code, bool), read_frame_op>{this}, token, &frm);
+    }
+
+    // Sends a single frame, taking ownership of it. Pass ZMQ_SNDMORE in flag for every part of
+    // a multipart message but the last. The handler signature is void(error_code const&).
+    template <typename WriteToken>
+    detail::initfn_result_t<WriteToken, void(error_code)> async_write_frame(frame&& frm,
+                                                                            int flag,
+                                                                            WriteToken&& token)
+    {
+        return detail::async_initiate<WriteToken, void(error_code)>(
+            write_initiation<frame_payload>{this}, token, std::move(frm), flag);
+    }
+
+    // Completes once per readiness notification with every message that could be received
+    // without blocking, up to max_batch. The handler signature is
+    // void(error_code const&, std::size_t count).
+    template <typename MessageContainer, typename ReadToken>
+    detail::initfn_result_t<ReadToken, void(error_code, size_t)> async_read_messages(
+        MessageContainer& buff, size_t max_batch, ReadToken&& token)
+    {
+        return detail::async_initiate<ReadToken, void(error_code, size_t)>(
+            initiation<void(error_code, size_t), read_messages_op, MessageContainer>{this}, token,
+            &buff, max_batch);
+    }
+
+    // The operations above with a deadline, a point in time on std::chrono::steady_clock. Once
+    // it passes the operation completes with boost::asio::error::timed_out (and a count of 0 or
+    // more of false): a read that has received nothing, leaving the next message for a later
+    // read, or a write still in the queue, which is then never sent. Only the operation itself
+    // gives up; other reads and the rest of the write queue carry on. The deadlines of all the
+    // sockets on an io_service share its deadline_service, so each costs O(1) however many are
+    // pending, and is honoured to within the service's tick.
+    //
+    // A deadline expires on the executor associated with the operation's handler, where the
+    // operation itself runs, and does nothing if the operation has finished by then. As with an
+    // Asio socket and a timer, an operation with a deadline has two things outstanding: on an
+    // io_service run by several threads, bind its handler to a strand.
+    template <typename OutputIt, typename ReadToken>
+    detail::initfn_result_t<ReadToken, void(error_code)> async_read_message(
+        OutputIt buff_it, time_point deadline, ReadToken&& token)
+    {
+        return detail::async_initiate<ReadToken, void(error_code)>(
+            deadline_initiation<void(error_code), read_message_op, OutputIt>{this}, token,
+            deadline, buff_it);
+    }
+
+    template <std::size_t N, typename ReadToken>
+    detail::initfn_result_t<ReadToken, void(error_code)> async_read_message(
+        basic_message<N>& msg, time_point deadline, ReadToken&& token)
+    {
+        msg.clear();
+        return async_read_message(std::back_inserter(msg), deadline,
+                                  std::forward<ReadToken>(token));
+    }
+
+    template <typename ReadToken>
+    detail::initfn_result_t<ReadToken, void(error_code, bool)> async_read_frame(
+        frame& frm, time_point deadline, ReadToken&& token)
+    {
+        return detail::async_initiate<ReadToken, void(error_code, bool)>(
+            deadline_initiation<void(error_code, bool), read_frame_op>{this}, token, deadline,
+            &frm);
+    }
+
+    template <typename MessageContainer, typename ReadToken>
+    detail::initfn_result_t<ReadToken, void(error_code, size_t)> async_read_messages(
+        MessageContainer& buff, size_t max_batch, time_point deadline, ReadToken&& token)
+    {
+        return detail::async_initiate<ReadToken, void(error_code, size_t)>(
+            deadline_initiation<void(error_code, size_t), read_messages_op, MessageContainer>{
+                this},
+            token, deadline, &buff, max_batch);
+    }
+
+    template <std::size_t N, typename WriteToken>
+    detail::initfn_result_t<WriteToken, void(error_code)> async_write_message(
+        basic_message<N> const& msg, time_point deadline, WriteToken&& token)
+    {
+        return async_write_message(msg.begin(), msg.end(), deadline,
+                                   std::forward<WriteToken>(token));
+    }
+
+    template <typename InputIt, typename WriteToken>
+    detail::initfn_result_t<WriteToken, void(error_code)> async_write_message(
+        InputIt first_it, InputIt last_it, time_point deadline, WriteToken&& token)
+    {
+        return detail::async_initiate<WriteToken, void(error_code)>(
+            deadline_write_initiation<message_payload<InputIt>>{this}, token, deadline, first_it,
+            last_it);
+    }
+
+    template <typename WriteToken>
+    detail::initfn_result_t<WriteToken, void(error_code)> async_write_frame(
+        frame&& frm, int flag, time_point deadline, WriteToken&& token)
+    {
+        return detail::async_initiate<WriteToken, void(error_code)>(
+            deadline_write_initiation<frame_payload>{this}, token, deadline, std::move(frm), flag);
+    }
+
+    // Delivers the next event of this socket's monitor. The first call starts monitoring the
+    // events in events (a mask of ZMQ_EVENT_* flags, ZMQ_EVENT_ALL for all) over an internal
+    // PAIR socket on the same io_service; the mask stays in force for the life of the socket
+    // and events arriving while no async_monitor is pending wait for the next one. cancel()
+    // also cancels a pending async_monitor. The handler signature is
+    // void(error_code const&, monitor_event const&).
+    template <typename MonitorToken>
+    detail::initfn_result_t<MonitorToken, void(error_code, monitor_event)> async_monitor(
+        int events, MonitorToken&& token)
+    {
+        return detail::async_initiate<MonitorToken, void(error_code, monitor_event)>(
+            monitor_initiation{this}, token, events);
     }
 
     template <typename Option>
     void get_option(Option& option,
                     typename socket_option::enable_if_raw<Option>::type* = nullptr) const
     {
+        static_assert(Option::readable, "this option cannot be read");
         size_t size = sizeof(option.value());
         if (-1 ==
             zmq_getsockopt(zsock_.get(), Option::id, static_cast<void*>(&option.value()), &size))
@@ -186,6 +1403,7 @@ public:
     void get_option(Option& option,
                     typename socket_option::enable_if_bool<Option>::type* = nullptr) const
     {
+        static_assert(Option::readable, "this option cannot be read");
         int v;
         size_t size = sizeof(v);
         if (-1 == zmq_getsockopt(zsock_.get(), Option::id, &v, &size)) throw exception();
@@ -196,6 +1414,7 @@ public:
     void set_option(Option const& option,
                     typename socket_option::enable_if_raw<Option>::type* = nullptr)
     {
+        static_assert(Option::writable, "this option cannot be written");
         typename Option::option_value_type v = option.value();
         size_t size = sizeof(v);
         if (-1 == zmq_setsockopt(zsock_.get(), Option::id, &v, size)) throw exception();
@@ -205,26 +1424,48 @@ public:
     void set_option(Option const& option,
                     typename socket_option::enable_if_bool<Option>::type* = nullptr)
     {
+        static_assert(Option::writable, "this option cannot be written");
         int v = static_cast<int>(option.value());
         size_t size = sizeof(v);
-        if (-1 == zmq_getsockopt(zsock_.get(), Option::id, &v, size)) throw exception();
+        if (-1 == zmq_setsockopt(zsock_.get(), Option::id, &v, size)) throw exception();
     }
 
+    // Reads straight into the option's storage. ZeroMQ reports a value that does not fit as
+    // EINVAL, so the storage is grown and the read retried up to max_binary_size bytes.
     template <typename Option>
     void get_option(Option& option,
                     typename socket_option::enable_if_binary<Option>::type* = nullptr) const
     {
-        std::array<uint8_t, socket_option::max_buff_size> buffer;
-        size_t size = socket_option::max_buff_size;
-        if (-1 == zmq_getsockopt(zsock_.get(), Option::id, buffer.data(), &size)) throw exception();
-        option.resize(size);
-        std::copy(buffer.data(), buffer.data() + size, static_cast<uint8_t*>(option.value()));
+        static_assert(Option::readable, "this option cannot be read");
+        option.resize(option.capacity());
+        for (;;) {
+            size_t size = option.size();
+            if (0 == zmq_getsockopt(zsock_.get(), Option::id, option.value(), &size)) {
+                option.resize(size);
+                return;
+            }
+            if (zmq_errno() != EINVAL || option.size() >= socket_option::max_binary_size)
+                throw exception();
+            option.resize(2 * option.size());
+        }
+    }
+
+    // Reads a binary option into a caller-provided buffer and returns its length. Throws with
+    // EINVAL when the value does not fit.
+    template <typename Option>
+    typename std::enable_if<socket_option::is_binary_option<Option>::value, size_t>::type
+    get_option(void* data, size_t size) const
+    {
+        static_assert(Option::readable, "this option cannot be read");
+        if (-1 == zmq_getsockopt(zsock_.get(), Option::id, data, &size)) throw exception();
+        return size;
     }
 
     template <typename Option>
     void set_option(Option const& option,
                     typename socket_option::enable_if_binary<Option>::type* = nullptr)
     {
+        static_assert(Option::writable, "this option cannot be written");
         if (-1 == zmq_setsockopt(zsock_.get(), Option::id, option.value(), option.size()))
             throw exception();
     }
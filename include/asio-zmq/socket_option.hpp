@@ -1,6 +1,8 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
+#include <cstring>
 #include <string>
 #include <type_traits>
 #include <vector>
@@ -14,8 +16,23 @@ namespace socket_option {
 
 std::size_t const max_buff_size = 255;
 
-template <int option, typename T> struct socket_option_impl {
+// Upper bound for the value of a binary option read by socket::get_option.
+std::size_t const max_binary_size = std::size_t(64) << 10;
+
+enum class access { read_only, write_only, read_write };
+
+// Every option carries its ZeroMQ id, value type, whether it may be read and written, and the
+// first libzmq version that knows it. socket::get_option/set_option check the access at compile
+// time. The version is for reference only: the table below leaves out the options that zmq.h
+// does not define, and zmq.h says nothing of the libzmq linked at run time.
+// Capacity only applies to binary options: the number of bytes stored without allocating.
+template <int option, typename T, access Access = access::read_write, int MinVersion = 0,
+          std::size_t Capacity = max_buff_size>
+struct socket_option_impl {
     static int const id = option;
+    static bool const readable = Access != access::write_only;
+    static bool const writable = Access != access::read_only;
+    static int const min_version = MinVersion;
     typedef T option_value_type;
 
     socket_option_impl(option_value_type value) : value_(value) {}
@@ -28,17 +45,52 @@ private:
     option_value_type value_;
 };
 
-template <int option> struct socket_option_impl<option, void*> {
+// Storage for a binary option value: up to N bytes are kept inline, longer values move to the
+// heap. Sized per option, so reading a routing id or an endpoint does not allocate.
+template <std::size_t N> class binary_value {
+private:
+    std::array<std::uint8_t, N> inline_;
+    std::vector<std::uint8_t> heap_;
+    std::size_t size_;
+
+public:
+    static std::size_t const inline_capacity = N;
+
+    binary_value() : size_(0) {}
+
+    binary_value(void const* data, std::size_t size) : size_(0)
+    {
+        resize(size);
+        std::memcpy(this->data(), data, size);
+    }
+
+    std::uint8_t* data() { return heap_.empty() ? inline_.data() : heap_.data(); }
+
+    std::uint8_t const* data() const { return heap_.empty() ? inline_.data() : heap_.data(); }
+
+    std::size_t size() const { return size_; }
+
+    std::size_t capacity() const { return heap_.empty() ? N : heap_.size(); }
+
+    // Contents are kept only while the value stays inline.
+    void resize(std::size_t size)
+    {
+        if (size > capacity()) heap_.resize(size);
+        size_ = size;
+    }
+};
+
+template <int option, access Access, int MinVersion, std::size_t Capacity>
+struct socket_option_impl<option, void*, Access, MinVersion, Capacity> {
     static int const id = option;
+    static bool const readable = Access != access::write_only;
+    static bool const writable = Access != access::read_only;
+    static int const min_version = MinVersion;
     typedef void* option_value_type;
 
     socket_option_impl() {}
 
-    socket_option_impl(void const* value, std::size_t size)
-        : value_(static_cast<std::uint8_t const*>(value),
-                 static_cast<std::uint8_t const*>(value) + size)
-    {
-    }
+    socket_option_impl(void const* value, std::size_t size) : value_(value, size) {}
 
     void const* value() const { return static_cast<void const*>(value_.data()); }
 
@@ -46,65 +98,225 @@ template <int option> struct socket_option_impl<option, void*> {
 
     std::size_t size() const { return value_.size(); }
 
-private:
-    std::vector<std::uint8_t> value_;
-};
+    std::size_t capacity() const { return value_.capacity(); }
 
-struct events : public socket_option_impl<ZMQ_EVENTS, int> {
-    static int const default_value = -1;
-    explicit events(int v = default_value) : socket_option_impl<ZMQ_EVENTS, int>(v) {}
-};
+    void resize(std::size_t size) { value_.resize(size); }
 
-struct send_buff_hwm : public socket_option_impl<ZMQ_SNDHWM, int> {
-    static int const default_value = 1000;
-    explicit send_buff_hwm(int v = default_value) : socket_option_impl<ZMQ_SNDHWM, int>(v) {}
-};
-
-struct recv_more : public socket_option_impl<ZMQ_RCVMORE, bool> {
-    static bool const default_value = false;
-    explicit recv_more(int v = default_value) : socket_option_impl<ZMQ_RCVMORE, bool>(v) {}
+private:
+    binary_value<Capacity> value_;
 };
 
-struct identity : public socket_option_impl<ZMQ_IDENTITY, void*> {
-    identity() {}
-    identity(void const* value, std::size_t size)
-        : socket_option_impl<ZMQ_IDENTITY, void*>(value, size)
-    {
-    }
-    identity(const std::string& value)
-        : socket_option_impl<ZMQ_IDENTITY, void*>(value.c_str(),value.size())
-    {
+// Defines an option holding a single value of the given type.
+#define ASIO_ZMQ_SOCKET_OPTION(name, option, type, mode, initial, major, minor, patch)            \
+    struct name                                                                                \
+        : public socket_option_impl<option, type, access::mode,                                \
+                                    ZMQ_MAKE_VERSION(major, minor, patch)> {                   \
+        static type const default_value = initial;                                             \
+        explicit name(type v = default_value)                                                  \
+            : socket_option_impl<option, type, access::mode,                                   \
+                                 ZMQ_MAKE_VERSION(major, minor, patch)>(v)                     \
+        {                                                                                      \
+        }                                                                                      \
     }
-};
 
-struct subscribe : public socket_option_impl<ZMQ_SUBSCRIBE, void*> {
-    subscribe() {}
-    subscribe(void const* value, std::size_t size)
-        : socket_option_impl<ZMQ_SUBSCRIBE, void*>(value, size)
-    {
+// Defines an option holding a byte string, capacity bytes of which are stored inline.
+#define ASIO_ZMQ_BINARY_SOCKET_OPTION(name, option, mode, capacity, major, minor, patch)          \
+    struct name                                                                                \
+        : public socket_option_impl<option, void*, access::mode,                               \
+                                    ZMQ_MAKE_VERSION(major, minor, patch), capacity> {         \
+        typedef socket_option_impl<option, void*, access::mode,                                \
+                                   ZMQ_MAKE_VERSION(major, minor, patch), capacity>            \
+            base_type;                                                                         \
+        name() {}                                                                              \
+        name(void const* value, std::size_t size) : base_type(value, size) {}                  \
+        name(std::string const& value) : base_type(value.c_str(), value.size()) {}             \
     }
-    subscribe(const std::string& value)
-        : socket_option_impl<ZMQ_SUBSCRIBE, void*>(value.c_str(), value.size())
-    {
-    }
-};
 
-struct fd : public socket_option_impl<ZMQ_FD, native_handle_type> {
-    static native_handle_type const default_value = -1;
-    explicit fd(native_handle_type v = default_value)
-        : socket_option_impl<ZMQ_FD, native_handle_type>(v)
-    {
-    }
-};
+// Options that the zmq.h in use does not define are left out.
 
-struct linger : public socket_option_impl<ZMQ_LINGER, int> {
-    static int const default_value = -1;
-    explicit linger(int v = default_value) : socket_option_impl<ZMQ_LINGER, int>(v) {}
-};
+#ifdef ZMQ_AFFINITY
+ASIO_ZMQ_SOCKET_OPTION(affinity, ZMQ_AFFINITY, std::uint64_t, read_write, 0, 3, 2, 0);
+#endif
+#ifdef ZMQ_BACKLOG
+ASIO_ZMQ_SOCKET_OPTION(backlog, ZMQ_BACKLOG, int, read_write, 100, 3, 2, 0);
+#endif
+#ifdef ZMQ_CONFLATE
+ASIO_ZMQ_SOCKET_OPTION(conflate, ZMQ_CONFLATE, bool, read_write, false, 4, 0, 0);
+#endif
+#ifdef ZMQ_CONNECT_TIMEOUT
+ASIO_ZMQ_SOCKET_OPTION(connect_timeout, ZMQ_CONNECT_TIMEOUT, int, read_write, 0, 4, 2, 0);
+#endif
+#ifdef ZMQ_EVENTS
+ASIO_ZMQ_SOCKET_OPTION(events, ZMQ_EVENTS, int, read_only, -1, 3, 2, 0);
+#endif
+#ifdef ZMQ_FD
+ASIO_ZMQ_SOCKET_OPTION(fd, ZMQ_FD, native_handle_type, read_only, -1, 3, 2, 0);
+#endif
+#ifdef ZMQ_HANDSHAKE_IVL
+ASIO_ZMQ_SOCKET_OPTION(handshake_ivl, ZMQ_HANDSHAKE_IVL, int, read_write, 30000, 4, 1, 0);
+#endif
+#ifdef ZMQ_HEARTBEAT_IVL
+ASIO_ZMQ_SOCKET_OPTION(heartbeat_ivl, ZMQ_HEARTBEAT_IVL, int, read_write, 0, 4, 2, 0);
+ASIO_ZMQ_SOCKET_OPTION(heartbeat_timeout, ZMQ_HEARTBEAT_TIMEOUT, int, read_write, -1, 4, 2, 0);
+ASIO_ZMQ_SOCKET_OPTION(heartbeat_ttl, ZMQ_HEARTBEAT_TTL, int, read_write, 0, 4, 2, 0);
+#endif
+#ifdef ZMQ_IMMEDIATE
+ASIO_ZMQ_SOCKET_OPTION(immediate, ZMQ_IMMEDIATE, bool, read_write, false, 4, 0, 0);
+#endif
+#ifdef ZMQ_IN_BATCH_SIZE
+ASIO_ZMQ_SOCKET_OPTION(in_batch_size, ZMQ_IN_BATCH_SIZE, int, read_write, 8192, 4, 3, 0);
+ASIO_ZMQ_SOCKET_OPTION(out_batch_size, ZMQ_OUT_BATCH_SIZE, int, read_write, 8192, 4, 3, 0);
+#endif
+#ifdef ZMQ_INVERT_MATCHING
+ASIO_ZMQ_SOCKET_OPTION(invert_matching, ZMQ_INVERT_MATCHING, bool, read_write, false, 4, 2, 0);
+#endif
+#ifdef ZMQ_IPV6
+ASIO_ZMQ_SOCKET_OPTION(ipv6, ZMQ_IPV6, bool, read_write, false, 4, 0, 0);
+#endif
+#ifdef ZMQ_LINGER
+ASIO_ZMQ_SOCKET_OPTION(linger, ZMQ_LINGER, int, read_write, -1, 3, 2, 0);
+#endif
+#ifdef ZMQ_MAXMSGSIZE
+ASIO_ZMQ_SOCKET_OPTION(max_msg_size, ZMQ_MAXMSGSIZE, std::int64_t, read_write, -1, 3, 2, 0);
+#endif
+#ifdef ZMQ_MECHANISM
+ASIO_ZMQ_SOCKET_OPTION(mechanism, ZMQ_MECHANISM, int, read_only, 0, 4, 0, 0);
+#endif
+#ifdef ZMQ_MULTICAST_HOPS
+ASIO_ZMQ_SOCKET_OPTION(multicast_hops, ZMQ_MULTICAST_HOPS, int, read_write, 1, 3, 2, 0);
+#endif
+#ifdef ZMQ_MULTICAST_MAXTPDU
+ASIO_ZMQ_SOCKET_OPTION(multicast_maxtpdu, ZMQ_MULTICAST_MAXTPDU, int, read_write, 1500, 4, 2, 0);
+#endif
+#ifdef ZMQ_PROBE_ROUTER
+ASIO_ZMQ_SOCKET_OPTION(probe_router, ZMQ_PROBE_ROUTER, bool, write_only, false, 4, 0, 0);
+#endif
+#ifdef ZMQ_RATE
+ASIO_ZMQ_SOCKET_OPTION(rate, ZMQ_RATE, int, read_write, 100, 3, 2, 0);
+#endif
+#ifdef ZMQ_RCVBUF
+ASIO_ZMQ_SOCKET_OPTION(recv_buff_size, ZMQ_RCVBUF, int, read_write, -1, 3, 2, 0);
+#endif
+#ifdef ZMQ_RCVHWM
+ASIO_ZMQ_SOCKET_OPTION(recv_buff_hwm, ZMQ_RCVHWM, int, read_write, 1000, 3, 2, 0);
+#endif
+#ifdef ZMQ_RCVMORE
+ASIO_ZMQ_SOCKET_OPTION(recv_more, ZMQ_RCVMORE, bool, read_only, false, 3, 2, 0);
+#endif
+#ifdef ZMQ_RCVTIMEO
+ASIO_ZMQ_SOCKET_OPTION(recv_timeout, ZMQ_RCVTIMEO, int, read_write, -1, 3, 2, 0);
+#endif
+#ifdef ZMQ_RECONNECT_IVL
+ASIO_ZMQ_SOCKET_OPTION(reconnect_ivl, ZMQ_RECONNECT_IVL, int, read_write, 100, 3, 2, 0);
+#endif
+#ifdef ZMQ_RECONNECT_IVL_MAX
+ASIO_ZMQ_SOCKET_OPTION(reconnect_ivl_max, ZMQ_RECONNECT_IVL_MAX, int, read_write, 0, 3, 2, 0);
+#endif
+#ifdef ZMQ_RECOVERY_IVL
+ASIO_ZMQ_SOCKET_OPTION(recovery_ivl, ZMQ_RECOVERY_IVL, int, read_write, 10000, 3, 2, 0);
+#endif
+#ifdef ZMQ_REQ_CORRELATE
+ASIO_ZMQ_SOCKET_OPTION(req_correlate, ZMQ_REQ_CORRELATE, bool, write_only, false, 4, 0, 0);
+ASIO_ZMQ_SOCKET_OPTION(req_relaxed, ZMQ_REQ_RELAXED, bool, write_only, false, 4, 0, 0);
+#endif
+#ifdef ZMQ_ROUTER_HANDOVER
+ASIO_ZMQ_SOCKET_OPTION(router_handover, ZMQ_ROUTER_HANDOVER, bool, write_only, false, 4, 1, 0);
+#endif
+#ifdef ZMQ_ROUTER_MANDATORY
+// Readable after libzmq 4.3.5, as is xpub_nodrop; 4.3.5 itself still answers EINVAL.
+#if ZMQ_VERSION > ZMQ_MAKE_VERSION(4, 3, 5)
+ASIO_ZMQ_SOCKET_OPTION(router_mandatory, ZMQ_ROUTER_MANDATORY, bool, read_write, false, 3, 2, 0);
+#else
+ASIO_ZMQ_SOCKET_OPTION(router_mandatory, ZMQ_ROUTER_MANDATORY, bool, write_only, false, 3, 2, 0);
+#endif
+#endif
+#ifdef ZMQ_ROUTER_NOTIFY
+ASIO_ZMQ_SOCKET_OPTION(router_notify, ZMQ_ROUTER_NOTIFY, int, read_write, 0, 4, 3, 0);
+#endif
+#ifdef ZMQ_SNDBUF
+ASIO_ZMQ_SOCKET_OPTION(send_buff_size, ZMQ_SNDBUF, int, read_write, -1, 3, 2, 0);
+#endif
+#ifdef ZMQ_SNDHWM
+ASIO_ZMQ_SOCKET_OPTION(send_buff_hwm, ZMQ_SNDHWM, int, read_write, 1000, 3, 2, 0);
+#endif
+#ifdef ZMQ_SNDTIMEO
+ASIO_ZMQ_SOCKET_OPTION(send_timeout, ZMQ_SNDTIMEO, int, read_write, -1, 3, 2, 0);
+#endif
+#ifdef ZMQ_TCP_KEEPALIVE
+ASIO_ZMQ_SOCKET_OPTION(tcp_keepalive, ZMQ_TCP_KEEPALIVE, int, read_write, -1, 3, 2, 0);
+ASIO_ZMQ_SOCKET_OPTION(tcp_keepalive_cnt, ZMQ_TCP_KEEPALIVE_CNT, int, read_write, -1, 3, 2, 0);
+ASIO_ZMQ_SOCKET_OPTION(tcp_keepalive_idle, ZMQ_TCP_KEEPALIVE_IDLE, int, read_write, -1, 3, 2, 0);
+ASIO_ZMQ_SOCKET_OPTION(tcp_keepalive_intvl, ZMQ_TCP_KEEPALIVE_INTVL, int, read_write, -1, 3, 2,
+                       0);
+#endif
+#ifdef ZMQ_TCP_MAXRT
+ASIO_ZMQ_SOCKET_OPTION(tcp_maxrt, ZMQ_TCP_MAXRT, int, read_write, 0, 4, 2, 0);
+#endif
+#ifdef ZMQ_THREAD_SAFE
+ASIO_ZMQ_SOCKET_OPTION(thread_safe, ZMQ_THREAD_SAFE, bool, read_only, false, 4, 2, 0);
+#endif
+#ifdef ZMQ_TOS
+ASIO_ZMQ_SOCKET_OPTION(tos, ZMQ_TOS, int, read_write, 0, 4, 1, 0);
+#endif
+#ifdef ZMQ_TYPE
+ASIO_ZMQ_SOCKET_OPTION(socket_type, ZMQ_TYPE, int, read_only, -1, 3, 2, 0);
+#endif
+#ifdef ZMQ_XPUB_NODROP
+#if ZMQ_VERSION > ZMQ_MAKE_VERSION(4, 3, 5)
+ASIO_ZMQ_SOCKET_OPTION(xpub_nodrop, ZMQ_XPUB_NODROP, bool, read_write, false, 4, 1, 0);
+#else
+ASIO_ZMQ_SOCKET_OPTION(xpub_nodrop, ZMQ_XPUB_NODROP, bool, write_only, false, 4, 1, 0);
+#endif
+#endif
+#ifdef ZMQ_XPUB_VERBOSE
+ASIO_ZMQ_SOCKET_OPTION(xpub_verbose, ZMQ_XPUB_VERBOSE, bool, write_only, false, 3, 2, 0);
+#endif
+
+#ifdef ZMQ_BIND_TO_DEVICE
+ASIO_ZMQ_BINARY_SOCKET_OPTION(bind_to_device, ZMQ_BIND_TO_DEVICE, read_write, 32, 4, 3, 0);
+#endif
+#ifdef ZMQ_CONNECT_ROUTING_ID
+ASIO_ZMQ_BINARY_SOCKET_OPTION(connect_routing_id, ZMQ_CONNECT_ROUTING_ID, write_only, 255,
+                              4, 2, 0);
+#endif
+#ifdef ZMQ_CURVE_SERVER
+ASIO_ZMQ_SOCKET_OPTION(curve_server, ZMQ_CURVE_SERVER, bool, read_write, false, 4, 0, 0);
+// Keys in their 32 byte binary form, which is what these read back.
+ASIO_ZMQ_BINARY_SOCKET_OPTION(curve_publickey, ZMQ_CURVE_PUBLICKEY, read_write, 32, 4, 0, 0);
+ASIO_ZMQ_BINARY_SOCKET_OPTION(curve_secretkey, ZMQ_CURVE_SECRETKEY, read_write, 32, 4, 0, 0);
+ASIO_ZMQ_BINARY_SOCKET_OPTION(curve_serverkey, ZMQ_CURVE_SERVERKEY, read_write, 32, 4, 0, 0);
+// The same keys as 40 characters of Z85 text. ZeroMQ hands Z85 back only to a buffer with room
+// for a terminating NUL, so a key read through these has size 41 and its value is a C string.
+ASIO_ZMQ_BINARY_SOCKET_OPTION(curve_publickey_z85, ZMQ_CURVE_PUBLICKEY, read_write, 41, 4, 0,
+                              0);
+ASIO_ZMQ_BINARY_SOCKET_OPTION(curve_secretkey_z85, ZMQ_CURVE_SECRETKEY, read_write, 41, 4, 0,
+                              0);
+ASIO_ZMQ_BINARY_SOCKET_OPTION(curve_serverkey_z85, ZMQ_CURVE_SERVERKEY, read_write, 41, 4, 0,
+                              0);
+#endif
+#ifdef ZMQ_IDENTITY
+ASIO_ZMQ_BINARY_SOCKET_OPTION(identity, ZMQ_IDENTITY, read_write, 255, 3, 2, 0);
+#endif
+#ifdef ZMQ_LAST_ENDPOINT
+ASIO_ZMQ_BINARY_SOCKET_OPTION(last_endpoint, ZMQ_LAST_ENDPOINT, read_only, 256, 3, 2, 0);
+#endif
+#ifdef ZMQ_SOCKS_PROXY
+ASIO_ZMQ_BINARY_SOCKET_OPTION(socks_proxy, ZMQ_SOCKS_PROXY, read_write, 256, 4, 1, 0);
+#endif
+#ifdef ZMQ_SUBSCRIBE
+ASIO_ZMQ_BINARY_SOCKET_OPTION(subscribe, ZMQ_SUBSCRIBE, write_only, 64, 3, 2, 0);
+ASIO_ZMQ_BINARY_SOCKET_OPTION(unsubscribe, ZMQ_UNSUBSCRIBE, write_only, 64, 3, 2, 0);
+#endif
+#ifdef ZMQ_ZAP_DOMAIN
+ASIO_ZMQ_BINARY_SOCKET_OPTION(zap_domain, ZMQ_ZAP_DOMAIN, read_write, 64, 4, 0, 0);
+#endif
+
+#undef ASIO_ZMQ_SOCKET_OPTION
+#undef ASIO_ZMQ_BINARY_SOCKET_OPTION
 
 template <typename OptionType>
 struct is_binary_option
-    : public std::is_base_of<socket_option_impl<OptionType::id, void*>, OptionType> {
+    : public std::is_same<typename OptionType::option_value_type, void*> {
 };
 
 template <typename OptionType>
@@ -112,8 +324,7 @@ struct enable_if_binary : public std::enable_if<is_binary_option<OptionType>::va
 };
 
 template <typename OptionType>
-struct is_bool_option
-    : public std::is_base_of<socket_option_impl<OptionType::id, bool>, OptionType> {
+struct is_bool_option : public std::is_same<typename OptionType::option_value_type, bool> {
 };
 
 template <typename OptionType>
@@ -122,11 +333,8 @@ struct enable_if_bool : public std::enable_if<is_bool_option<OptionType>::value>
 
 template <typename OptionType>
 struct is_raw_option
-    : public std::integral_constant<
-          bool, std::is_base_of<
-                    socket_option_impl<OptionType::id, typename OptionType::option_value_type>,
-                    OptionType>::value &&
-                    !is_bool_option<OptionType>::value && !is_binary_option<OptionType>::value> {
+    : public std::integral_constant<bool, !is_bool_option<OptionType>::value &&
+                                              !is_binary_option<OptionType>::value> {
 };
 
 template <typename OptionType>
@@ -0,0 +1,304 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <boost/asio/detail/handler_cont_helpers.hpp>
+#include <boost/asio/detail/handler_invoke_helpers.hpp>
+#include "handler_memory.hpp"
+#include "histogram.hpp"
+
+// Socket instrumentation is compiled in only when ASIO_ZMQ_ENABLE_STATS is defined (to any
+// value) before the first asio-zmq header; otherwise every counter below is an empty inline
+// function and socket::stats() reports zeros.
+
+namespace boost {
+namespace asio {
+namespace zmq {
+
+// Snapshot of a socket's counters. Times are in nanoseconds.
+struct socket_stats {
+#if defined(ASIO_ZMQ_ENABLE_STATS)
+    static bool const enabled = true;
+#else
+    static bool const enabled = false;
+#endif
+
+    std::uint64_t messages_sent;
+    std::uint64_t frames_sent;
+    std::uint64_t bytes_sent;
+    std::uint64_t messages_received;
+    std::uint64_t frames_received;
+    std::uint64_t bytes_received;
+    // Non-blocking sends and receives that ZeroMQ answered with EAGAIN.
+    std::uint64_t would_block;
+    // Completed waits on the socket's ZMQ_FD.
+    std::uint64_t wakeups;
+    // Wakeups after which the operation found nothing to do and had to wait again.
+    std::uint64_t spurious_wakeups;
+    // From a completion being queued on the io_service to its handler starting.
+    histogram queue_delay;
+    // From the wakeup that let an operation finish to its handler starting; this includes the
+    // queue delay. Operations that finished without waiting are not recorded.
+    histogram ready_to_handler;
+
+    socket_stats()
+        : messages_sent(0),
+          frames_sent(0),
+          bytes_sent(0),
+          messages_received(0),
+          frames_received(0),
+          bytes_received(0),
+          would_block(0),
+          wakeups(0),
+          spurious_wakeups(0),
+          queue_delay(),
+          ready_to_handler()
+    {
+    }
+};
+
+namespace detail {
+
+#if defined(ASIO_ZMQ_ENABLE_STATS)
+
+// A point in time, or none.
+class stats_stamp {
+private:
+    typedef std::chrono::steady_clock clock;
+
+    clock::time_point time_;
+    bool set_;
+
+public:
+    stats_stamp() : time_(), set_(false) {}
+
+    static stats_stamp now()
+    {
+        stats_stamp s;
+        s.time_ = clock::now();
+        s.set_ = true;
+        return s;
+    }
+
+    bool is_set() const { return set_; }
+
+    std::uint64_t nanoseconds_until(stats_stamp const& later) const
+    {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(later.time_ - time_).count());
+    }
+};
+
+// The counters a socket updates from its own thread. Other threads may read them through
+// snapshot() at any time; relaxed atomics written with plain loads and stores keep the hot
+// path free of locked instructions. The two histograms are the exception: handlers record
+// into them when they start, on their associated executors, which may be several threads at
+// once, so atomic_histogram takes concurrent samples.
+class socket_counters {
+private:
+    typedef std::atomic<std::uint64_t> counter;
+
+    counter messages_sent_;
+    counter frames_sent_;
+    counter bytes_sent_;
+    counter messages_received_;
+    counter frames_received_;
+    counter bytes_received_;
+    counter would_block_;
+    counter wakeups_;
+    counter spurious_wakeups_;
+    atomic_histogram queue_delay_;
+    atomic_histogram ready_to_handler_;
+
+    static void add(counter& c, std::uint64_t n)
+    {
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    static std::uint64_t get(counter const& c) { return c.load(std::memory_order_relaxed); }
+
+public:
+    socket_counters()
+        : messages_sent_(0),
+          frames_sent_(0),
+          bytes_sent_(0),
+          messages_received_(0),
+          frames_received_(0),
+          bytes_received_(0),
+          would_block_(0),
+          wakeups_(0),
+          spurious_wakeups_(0)
+    {
+    }
+
+    void frame_sent(std::size_t bytes, bool more)
+    {
+        add(frames_sent_, 1);
+        add(bytes_sent_, bytes);
+        if (!more) add(messages_sent_, 1);
+    }
+
+    template <typename Frame> void frame_received(Frame const& frm)
+    {
+        add(frames_received_, 1);
+        add(bytes_received_, frm.size());
+        if (!frm.more()) add(messages_received_, 1);
+    }
+
+    void would_block() { add(would_block_, 1); }
+
+    void wakeup() { add(wakeups_, 1); }
+
+    void spurious_wakeup() { add(spurious_wakeups_, 1); }
+
+    void handler_started(stats_stamp const& queued, stats_stamp const& ready)
+    {
+        stats_stamp started = stats_stamp::now();
+        queue_delay_.record(queued.nanoseconds_until(started));
+        if (ready.is_set()) ready_to_handler_.record(ready.nanoseconds_until(started));
+    }
+
+    socket_stats snapshot() const
+    {
+        socket_stats s;
+        s.messages_sent = get(messages_sent_);
+        s.frames_sent = get(frames_sent_);
+        s.bytes_sent = get(bytes_sent_);
+        s.messages_received = get(messages_received_);
+        s.frames_received = get(frames_received_);
+        s.bytes_received = get(bytes_received_);
+        s.would_block = get(would_block_);
+        s.wakeups = get(wakeups_);
+        s.spurious_wakeups = get(spurious_wakeups_);
+        s.queue_delay = queue_delay_.snapshot();
+        s.ready_to_handler = ready_to_handler_.snapshot();
+        return s;
+    }
+};
+
+// Per-operation record of the wait on ZMQ_FD in progress and of the last wakeup.
+class op_timing {
+private:
+    stats_stamp ready_;
+    bool waiting_;
+    bool woken_;
+
+public:
+    op_timing() : ready_(), waiting_(false), woken_(false) {}
+
+    // Called on entry to the operation; counts the entry as a wakeup if it ends a wait.
+    void resume(socket_counters& counters)
+    {
+        woken_ = waiting_;
+        if (!waiting_) return;
+        waiting_ = false;
+        ready_ = stats_stamp::now();
+        counters.wakeup();
+    }
+
+    // Called before waiting again; a wakeup that made no progress was spurious.
+    void wait(socket_counters& counters, bool progress = false)
+    {
+        if (woken_ && !progress) counters.spurious_wakeup();
+        woken_ = false;
+        waiting_ = true;
+    }
+
+    stats_stamp ready() const { return ready_; }
+};
+
+// Wraps a user handler to time how long it waited to run. The counters belong to the socket,
+// so the sample is dropped if the socket has been destroyed by the time the handler runs, and
+// nothing is touched after the handler returns, as it may destroy the socket itself.
+// The executor, allocator, invocation and continuation hooks are forwarded so that handlers
+// bound to a strand keep their guarantees.
+template <typename Handler>
+class timed_handler : public handler_holder<Handler>, public allocator_binding<Handler> {
+private:
+    socket_counters* counters_;
+    handler_memory::lifeline lifeline_;
+    stats_stamp queued_;
+    stats_stamp ready_;
+
+public:
+    timed_handler(Handler&& handler, socket_counters& counters, handler_memory& memory,
+                  stats_stamp const& ready)
+        : handler_holder<Handler>(std::move(handler)),
+          allocator_binding<Handler>(this->handler_),
+          counters_(&counters),
+          lifeline_(memory),
+          queued_(stats_stamp::now()),
+          ready_(ready)
+    {
+    }
+
+    template <typename... Args> void operator()(Args const&... args)
+    {
+        if (lifeline_.alive()) counters_->handler_started(queued_, ready_);
+        this->handler_(args...);
+    }
+
+    template <typename Function>
+    friend void asio_handler_invoke(Function& func, timed_handler* self)
+    {
+        boost_asio_handler_invoke_helpers::invoke(func, self->handler_);
+    }
+
+    template <typename Function>
+    friend void asio_handler_invoke(Function const& func, timed_handler* self)
+    {
+        boost_asio_handler_invoke_helpers::invoke(func, self->handler_);
+    }
+
+    friend bool asio_handler_is_continuation(timed_handler* self)
+    {
+        return boost_asio_handler_cont_helpers::is_continuation(self->handler_);
+    }
+};
+
+template <typename Handler>
+timed_handler<Handler> time_handler(Handler&& handler, socket_counters& counters,
+                                    handler_memory& memory, stats_stamp const& ready)
+{
+    return timed_handler<Handler>(std::move(handler), counters, memory, ready);
+}
+
+#else
+
+class stats_stamp {
+public:
+    static stats_stamp now() { return stats_stamp(); }
+};
+
+class socket_counters {
+public:
+    void frame_sent(std::size_t, bool) {}
+    template <typename Frame> void frame_received(Frame const&) {}
+    void would_block() {}
+    void wakeup() {}
+    void spurious_wakeup() {}
+    socket_stats snapshot() const { return socket_stats(); }
+};
+
+class op_timing {
+public:
+    void resume(socket_counters&) {}
+    void wait(socket_counters&, bool = false) {}
+    stats_stamp ready() const { return stats_stamp(); }
+};
+
+template <typename Handler>
+Handler&& time_handler(Handler&& handler, socket_counters&, handler_memory&, stats_stamp const&)
+{
+    return std::move(handler);
+}
+
+#endif
+
+}  // namespace detail
+}  // namespace zmq
+}  // namespace asio
+}  // namespace boost
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <boost/system/error_code.hpp>
+
+namespace boost {
+namespace asio {
+namespace zmq {
+namespace detail {
+
+// An asynchronous write waiting in a socket's queue. Like Asio's own operations it goes through
+// function pointers rather than virtual functions, so that the concrete type, which owns the
+// user's handler, can release its memory before the handler runs.
+class write_op {
+public:
+    typedef bool (*perform_func)(write_op*);
+    typedef void (*complete_func)(write_op*, boost::system::error_code const*);
+
+    // Tries to hand the payload to ZeroMQ without blocking; false means it would block.
+    bool perform() { return perform_(this); }
+
+    // Destroys the operation and then completes its handler with ec.
+    void complete(boost::system::error_code const& ec) { complete_(this, &ec); }
+
+    // Destroys the operation without invoking its handler.
+    void destroy() { complete_(this, nullptr); }
+
+protected:
+    write_op(perform_func perform, complete_func complete)
+        : prev_(nullptr), next_(nullptr), perform_(perform), complete_(complete)
+    {
+    }
+
+    ~write_op() {}
+
+private:
+    friend class write_queue;
+
+    write_op* prev_;
+    write_op* next_;
+    perform_func perform_;
+    complete_func complete_;
+};
+
+// Intrusive FIFO of write operations; pushing, popping and erasing never allocate and take
+// constant time.
+class write_queue {
+private:
+    write_op* front_;
+    write_op* back_;
+
+public:
+    write_queue() : front_(nullptr), back_(nullptr) {}
+
+    write_queue(write_queue const&) = delete;
+    write_queue& operator=(write_queue const&) = delete;
+
+    // A socket fails its queue before it goes; anything left is destroyed unfinished.
+    ~write_queue()
+    {
+        while (write_op* op = front_) {
+            pop();
+            op->destroy();
+        }
+    }
+
+    bool empty() const { return front_ == nullptr; }
+
+    write_op* front() const { return front_; }
+
+    void push(write_op* op)
+    {
+        op->prev_ = back_;
+        op->next_ = nullptr;
+        if (back_ != nullptr)
+            back_->next_ = op;
+        else
+            front_ = op;
+        back_ = op;
+    }
+
+    void pop()
+    {
+        if (front_ != nullptr) erase(front_);
+    }
+
+    // Removes op, which must be in the queue, from wherever it is.
+    void erase(write_op* op)
+    {
+        if (op->prev_ != nullptr)
+            op->prev_->next_ = op->next_;
+        else
+            front_ = op->next_;
+        if (op->next_ != nullptr)
+            op->next_->prev_ = op->prev_;
+        else
+            back_ = op->prev_;
+        op->prev_ = nullptr;
+        op->next_ = nullptr;
+    }
+};
+
+}  // namespace detail
+}  // namespace zmq
+}  // namespace asio
+}  // namespace boost
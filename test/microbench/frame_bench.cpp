@@ -0,0 +1,120 @@
+#include <cstring>
+#include <string>
+#include <utility>
+#include <benchmark/benchmark.h>
+#include <asio-zmq.hpp>
+
+//  Construction, copying and moving of frames. Sizes straddle ZeroMQ's
+//  33-byte very-small-message limit: below it the bytes live inside the
+//  zmq_msg_t, above it in a reference-counted heap block.
+
+namespace zmq = boost::asio::zmq;
+
+static void frame_empty(benchmark::State& state)
+{
+    for (auto _ : state) {
+        zmq::frame frm;
+        benchmark::DoNotOptimize(frm);
+    }
+}
+BENCHMARK(frame_empty);
+
+static void frame_sized(benchmark::State& state)
+{
+    std::size_t size = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+        zmq::frame frm(size);
+        benchmark::DoNotOptimize(frm.data());
+    }
+}
+BENCHMARK(frame_sized)->Arg(8)->Arg(64)->Arg(1024)->Arg(65536);
+
+static void frame_from_string(benchmark::State& state)
+{
+    std::string const str(static_cast<std::size_t>(state.range(0)), 'x');
+    for (auto _ : state) {
+        zmq::frame frm(str);
+        benchmark::DoNotOptimize(frm.data());
+    }
+}
+BENCHMARK(frame_from_string)->Arg(8)->Arg(64)->Arg(1024)->Arg(65536);
+
+//  A string built for the frame and then copied into it, against the same
+//  string handed over without a copy; the difference is what zero-copy saves.
+static void frame_from_string_copy(benchmark::State& state)
+{
+    std::string const src(static_cast<std::size_t>(state.range(0)), 'x');
+    for (auto _ : state) {
+        std::string str(src);
+        zmq::frame frm(str);
+        benchmark::DoNotOptimize(frm.data());
+    }
+}
+BENCHMARK(frame_from_string_copy)->Arg(64)->Arg(1024)->Arg(65536);
+
+static void frame_from_string_move(benchmark::State& state)
+{
+    std::string const src(static_cast<std::size_t>(state.range(0)), 'x');
+    for (auto _ : state) {
+        std::string str(src);
+        zmq::frame frm(std::move(str));
+        benchmark::DoNotOptimize(frm.data());
+    }
+}
+BENCHMARK(frame_from_string_move)->Arg(64)->Arg(1024)->Arg(65536);
+
+//  The copy constructor shares the payload through zmq_msg_copy.
+static void frame_copy(benchmark::State& state)
+{
+    zmq::frame const src(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        zmq::frame frm(src);
+        benchmark::DoNotOptimize(frm.data());
+    }
+}
+BENCHMARK(frame_copy)->Arg(8)->Arg(64)->Arg(1024)->Arg(65536);
+
+//  What the copy would cost without sharing: a new payload and a memcpy.
+static void frame_deep_copy(benchmark::State& state)
+{
+    zmq::frame const src(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        zmq::frame frm(src.size());
+        std::memcpy(frm.data(), src.data(), src.size());
+        benchmark::DoNotOptimize(frm.data());
+    }
+}
+BENCHMARK(frame_deep_copy)->Arg(8)->Arg(64)->Arg(1024)->Arg(65536);
+
+static void frame_move(benchmark::State& state)
+{
+    zmq::frame a(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        zmq::frame b(std::move(a));
+        a = std::move(b);
+        benchmark::DoNotOptimize(a.data());
+    }
+}
+BENCHMARK(frame_move)->Arg(8)->Arg(1024);
+
+static void frame_pool_make_frame(benchmark::State& state)
+{
+    std::size_t size = static_cast<std::size_t>(state.range(0));
+    zmq::frame_pool pool(size);
+    for (auto _ : state) {
+        zmq::frame frm = pool.make_frame(size);
+        benchmark::DoNotOptimize(frm.data());
+    }
+}
+BENCHMARK(frame_pool_make_frame)->Arg(64)->Arg(1024)->Arg(65536);
+
+static void message_push_back(benchmark::State& state)
+{
+    int frames = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        zmq::message msg;
+        for (int i = 0; i < frames; ++i) msg.push_back(zmq::frame(64));
+        benchmark::DoNotOptimize(msg.size());
+    }
+}
+BENCHMARK(message_push_back)->Arg(1)->Arg(3)->Arg(8);
@@ -0,0 +1,118 @@
+#include <cstdint>
+#include <benchmark/benchmark.h>
+#include <boost/asio.hpp>
+#include <asio-zmq.hpp>
+
+//  socket::get_option/set_option for each kind of option the table knows:
+//  int, 64-bit, bool and binary values, plus the getsockopt-backed queries
+//  the asynchronous operations make on every wakeup.
+
+namespace zmq = boost::asio::zmq;
+
+namespace {
+
+struct fixture {
+    boost::asio::io_service ios;
+    zmq::context ctx;
+    zmq::socket sock;
+
+    fixture() : ios(), ctx(), sock(ios, ctx, ZMQ_DEALER) {}
+};
+
+}  // namespace
+
+static void get_option_int(benchmark::State& state)
+{
+    fixture f;
+    zmq::socket_option::linger opt;
+    for (auto _ : state) {
+        f.sock.get_option(opt);
+        benchmark::DoNotOptimize(opt.value());
+    }
+}
+BENCHMARK(get_option_int);
+
+static void set_option_int(benchmark::State& state)
+{
+    fixture f;
+    zmq::socket_option::linger opt(0);
+    for (auto _ : state) f.sock.set_option(opt);
+}
+BENCHMARK(set_option_int);
+
+static void get_option_uint64(benchmark::State& state)
+{
+    fixture f;
+    zmq::socket_option::affinity opt;
+    for (auto _ : state) {
+        f.sock.get_option(opt);
+        benchmark::DoNotOptimize(opt.value());
+    }
+}
+BENCHMARK(get_option_uint64);
+
+static void get_option_bool(benchmark::State& state)
+{
+    fixture f;
+    zmq::socket_option::immediate opt;
+    for (auto _ : state) {
+        f.sock.get_option(opt);
+        benchmark::DoNotOptimize(opt.value());
+    }
+}
+BENCHMARK(get_option_bool);
+
+static void set_option_bool(benchmark::State& state)
+{
+    fixture f;
+    zmq::socket_option::immediate opt(true);
+    for (auto _ : state) f.sock.set_option(opt);
+}
+BENCHMARK(set_option_bool);
+
+static void get_option_binary(benchmark::State& state)
+{
+    fixture f;
+    f.sock.set_option(zmq::socket_option::identity("microbench-identity"));
+    zmq::socket_option::identity opt;
+    for (auto _ : state) {
+        f.sock.get_option(opt);
+        benchmark::DoNotOptimize(opt.value());
+    }
+}
+BENCHMARK(get_option_binary);
+
+//  The same option read into a caller-provided buffer.
+static void get_option_binary_buffer(benchmark::State& state)
+{
+    fixture f;
+    f.sock.set_option(zmq::socket_option::identity("microbench-identity"));
+    char buff[256];
+    for (auto _ : state) {
+        std::size_t size = f.sock.get_option<zmq::socket_option::identity>(buff, sizeof(buff));
+        benchmark::DoNotOptimize(size);
+    }
+}
+BENCHMARK(get_option_binary_buffer);
+
+static void set_option_binary(benchmark::State& state)
+{
+    fixture f;
+    zmq::socket_option::identity opt("microbench-identity");
+    for (auto _ : state) f.sock.set_option(opt);
+}
+BENCHMARK(set_option_binary);
+
+static void has_more(benchmark::State& state)
+{
+    fixture f;
+    for (auto _ : state) benchmark::DoNotOptimize(f.sock.has_more());
+}
+BENCHMARK(has_more);
+
+static void is_readable(benchmark::State& state)
+{
+    fixture f;
+    for (auto _ : state) benchmark::DoNotOptimize(f.sock.is_readable());
+}
+BENCHMARK(is_readable);
@@ -0,0 +1,171 @@
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <benchmark/benchmark.h>
+#include <boost/asio.hpp>
+#include <asio-zmq.hpp>
+
+//  Messages over an inproc PAIR within one thread, and the cost of completing
+//  an asynchronous operation through the io_service. Frames are built inside
+//  the timed loop because sending empties them.
+
+namespace zmq = boost::asio::zmq;
+
+namespace {
+
+//  The work object keeps run_one() from stopping the io_service whenever it
+//  runs out of handlers between iterations.
+struct pair_fixture {
+    boost::asio::io_service ios;
+    boost::asio::io_service::work work;
+    zmq::context ctx;
+    zmq::socket a;
+    zmq::socket b;
+
+    pair_fixture() : ios(), work(ios), ctx(), a(ios, ctx, ZMQ_PAIR), b(ios, ctx, ZMQ_PAIR)
+    {
+        static int next = 0;
+        std::string ep = "inproc://microbench." + std::to_string(next++);
+        a.bind(ep);
+        b.connect(ep);
+    }
+};
+
+}  // namespace
+
+static void fill(zmq::message& msg, int frames, std::size_t size)
+{
+    msg.clear();
+    for (int i = 0; i < frames; ++i) msg.push_back(zmq::frame(size));
+}
+
+static void write_read_message(benchmark::State& state)
+{
+    pair_fixture f;
+    int frames = static_cast<int>(state.range(0));
+    zmq::message out;
+    zmq::message in;
+    for (auto _ : state) {
+        fill(out, frames, 64);
+        f.a.write_message(out);
+        f.b.read_message(in);
+        benchmark::DoNotOptimize(in.size());
+    }
+    state.SetItemsProcessed(state.iterations() * frames);
+}
+BENCHMARK(write_read_message)->Arg(1)->Arg(3)->Arg(8);
+
+static void write_read_frame(benchmark::State& state)
+{
+    pair_fixture f;
+    for (auto _ : state) {
+        f.a.write_frame(zmq::frame(64));
+        zmq::frame frm = f.b.read_frame();
+        benchmark::DoNotOptimize(frm.data());
+    }
+}
+BENCHMARK(write_read_frame);
+
+//  Baseline for the asynchronous cases: one handler posted and run.
+static void io_service_post(benchmark::State& state)
+{
+    boost::asio::io_service ios;
+    boost::asio::io_service::work work(ios);
+    int done = 0;
+    for (auto _ : state) {
+        ios.post([&done] { ++done; });
+        ios.run_one();
+    }
+    benchmark::DoNotOptimize(done);
+}
+BENCHMARK(io_service_post);
+
+//  An async_write_message and an async_read_message that both find the socket
+//  ready, completed in the socket's completion mode: 0 posts, 1 dispatches.
+static void async_write_read_message(benchmark::State& state)
+{
+    pair_fixture f;
+    zmq::completion_mode mode =
+        state.range(1) == 0 ? zmq::completion_mode::post : zmq::completion_mode::dispatch;
+    f.a.set_completion_mode(mode);
+    f.b.set_completion_mode(mode);
+
+    int frames = static_cast<int>(state.range(0));
+    zmq::message out;
+    zmq::message in;
+    int done = 0;
+    auto handler = [&done](boost::system::error_code const&) { ++done; };
+    for (auto _ : state) {
+        fill(out, frames, 64);
+        done = 0;
+        f.a.async_write_message(out, handler);
+        f.b.async_read_message(in, handler);
+        while (done < 2) f.ios.run_one();
+    }
+    state.SetItemsProcessed(state.iterations() * frames);
+}
+BENCHMARK(async_write_read_message)->Args({1, 0})->Args({1, 1})->Args({3, 0})->Args({8, 0});
+
+static void async_write_read_frame(benchmark::State& state)
+{
+    pair_fixture f;
+    zmq::completion_mode mode =
+        state.range(0) == 0 ? zmq::completion_mode::post : zmq::completion_mode::dispatch;
+    f.a.set_completion_mode(mode);
+    f.b.set_completion_mode(mode);
+
+    zmq::frame in;
+    int done = 0;
+    for (auto _ : state) {
+        done = 0;
+        f.a.async_write_frame(zmq::frame(64), 0,
+                              [&done](boost::system::error_code const&) { ++done; });
+        f.b.async_read_frame(in, [&done](boost::system::error_code const&, bool) { ++done; });
+        while (done < 2) f.ios.run_one();
+    }
+}
+BENCHMARK(async_write_read_frame)->Arg(0)->Arg(1);
+
+//  async_write_read_frame in post mode with a deadline on the read that is
+//  never reached: the cost of scheduling and cancelling it in the timer wheel.
+static void async_write_read_frame_deadline(benchmark::State& state)
+{
+    pair_fixture f;
+    zmq::frame in;
+    int done = 0;
+    for (auto _ : state) {
+        done = 0;
+        f.a.async_write_frame(zmq::frame(64), 0,
+                              [&done](boost::system::error_code const&) { ++done; });
+        f.b.async_read_frame(in, std::chrono::steady_clock::now() + std::chrono::seconds(10),
+                             [&done](boost::system::error_code const&, bool) { ++done; });
+        while (done < 2) f.ios.run_one();
+    }
+}
+BENCHMARK(async_write_read_frame_deadline);
+
+#if BOOST_VERSION >= 107700
+//  async_write_read_frame in post mode with both handlers bound to a
+//  cancellation slot that is never signalled: the cost of connecting to and
+//  clearing the slot, and of the read's abandonable state.
+static void async_write_read_frame_cancellable(benchmark::State& state)
+{
+    pair_fixture f;
+    boost::asio::cancellation_signal write_signal;
+    boost::asio::cancellation_signal read_signal;
+    zmq::frame in;
+    int done = 0;
+    for (auto _ : state) {
+        done = 0;
+        f.a.async_write_frame(zmq::frame(64), 0,
+                              boost::asio::bind_cancellation_slot(
+                                  write_signal.slot(),
+                                  [&done](boost::system::error_code const&) { ++done; }));
+        f.b.async_read_frame(in, boost::asio::bind_cancellation_slot(
+                                     read_signal.slot(),
+                                     [&done](boost::system::error_code const&, bool) { ++done; }));
+        while (done < 2) f.ios.run_one();
+    }
+}
+BENCHMARK(async_write_read_frame_cancellable);
+#endif
@@ -0,0 +1,363 @@
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include <asio-zmq.hpp>
+#include "helper.hpp"
+
+//  One driver for the whole suite: every combination of the parameter lists
+//  given on the command line is run in turn and the results are printed as a
+//  JSON array. pushpull scenarios measure throughput, reqrep scenarios time
+//  every roundtrip as the latency tests do.
+//
+//  The api flavours follow the single-scenario programs: async runs both ends
+//  of a pair on one shard of a runtime, sync runs each end in a thread of its
+//  own with the blocking calls, and poll drives both ends of a pair from one
+//  thread with zmq_poll on bare libzmq sockets.
+
+namespace perf = boost::asio::zmq::test::perf;
+
+static char const usage[] =
+    "usage: asio_zmq_bench [<parameter>=<value>[,<value>...]]...\n"
+    "  size=64              message sizes [B]\n"
+    "  count=100000         messages (pushpull) or roundtrips (reqrep) per pair\n"
+    "  transport=inproc     inproc, ipc, tcp\n"
+    "  pattern=pushpull     pushpull, reqrep\n"
+    "  api=async            async, sync, poll\n"
+    "  io-threads=1         ZeroMQ I/O threads\n"
+    "  pairs=1              concurrent socket pairs\n"
+    "  port=5600            first tcp port\n";
+
+struct scenario {
+    int message_size;
+    int count;
+    std::string transport;
+    std::string pattern;
+    std::string api;
+    int io_threads;
+    int pairs;
+};
+
+struct outcome {
+    double elapsed_us;
+    boost::asio::zmq::histogram latency;
+};
+
+struct parameters {
+    std::vector<int> sizes{64};
+    std::vector<int> counts{100000};
+    std::vector<std::string> transports{"inproc"};
+    std::vector<std::string> patterns{"pushpull"};
+    std::vector<std::string> apis{"async"};
+    std::vector<int> io_threads{1};
+    std::vector<int> pairs{1};
+    int port = 5600;
+};
+
+static std::vector<std::string> split(std::string const& list)
+{
+    std::vector<std::string> values;
+    std::istringstream is(list);
+    std::string value;
+    while (std::getline(is, value, ',')) values.push_back(value);
+    return values;
+}
+
+static bool parse_numbers(std::string const& list, std::vector<int>& out)
+{
+    out.clear();
+    for (auto const& v : split(list)) {
+        int n = std::atoi(v.c_str());
+        if (n <= 0) return false;
+        out.push_back(n);
+    }
+    return !out.empty();
+}
+
+static bool parse_names(std::string const& list, std::vector<std::string>& out,
+                        std::vector<std::string> const& allowed)
+{
+    out = split(list);
+    for (auto const& v : out) {
+        bool known = false;
+        for (auto const& a : allowed) known = known || v == a;
+        if (!known) return false;
+    }
+    return !out.empty();
+}
+
+static bool parse_argument(std::string const& arg, parameters& p)
+{
+    auto eq = arg.find('=');
+    if (eq == std::string::npos) return false;
+    std::string key = arg.substr(0, eq);
+    std::string value = arg.substr(eq + 1);
+
+    if (key == "size") return parse_numbers(value, p.sizes);
+    if (key == "count") return parse_numbers(value, p.counts);
+    if (key == "transport") return parse_names(value, p.transports, {"inproc", "ipc", "tcp"});
+    if (key == "pattern") return parse_names(value, p.patterns, {"pushpull", "reqrep"});
+    if (key == "api") return parse_names(value, p.apis, {"async", "sync", "poll"});
+    if (key == "io-threads") return parse_numbers(value, p.io_threads);
+    if (key == "pairs") return parse_numbers(value, p.pairs);
+    if (key == "port") {
+        p.port = std::atoi(value.c_str());
+        return p.port > 0;
+    }
+    return false;
+}
+
+typedef std::chrono::steady_clock bench_clock;
+
+static double microseconds_since(bench_clock::time_point start)
+{
+    return static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - start).count()) /
+           1000.0;
+}
+
+//  async: both ends of pair i on shard i of a runtime.
+static outcome run_async(scenario const& s, std::vector<std::string> const& eps)
+{
+    boost::asio::zmq::runtime rt(s.pairs, false);
+    rt.get_context().set_io_threads(s.io_threads);
+
+    std::vector<std::unique_ptr<perf::latency_recorder>> recorders;
+    std::vector<std::unique_ptr<perf::puller>> pullers;
+    std::vector<std::unique_ptr<perf::pusher>> pushers;
+    std::vector<std::unique_ptr<perf::replier>> repliers;
+    std::vector<std::unique_ptr<perf::requester>> requesters;
+
+    for (int i = 0; i < s.pairs; ++i) {
+        if (s.pattern == "pushpull") {
+            pullers.emplace_back(new perf::puller(rt.shard(i), rt.get_context(), s.count, eps[i]));
+            pushers.emplace_back(new perf::pusher(rt.shard(i), rt.get_context(), s.count,
+                                                  s.message_size, eps[i]));
+        }
+        else {
+            recorders.emplace_back(new perf::latency_recorder());
+            repliers.emplace_back(
+                new perf::replier(rt.shard(i), rt.get_context(), s.count, eps[i]));
+            requesters.emplace_back(new perf::requester(
+                rt.shard(i), rt.get_context(), s.count, s.message_size, eps[i],
+                boost::asio::zmq::completion_mode::post, recorders.back().get()));
+        }
+    }
+
+    auto start = bench_clock::now();
+    rt.run();
+
+    outcome o{microseconds_since(start), boost::asio::zmq::histogram()};
+    for (auto const& r : recorders) o.latency.merge(r->results());
+    return o;
+}
+
+//  sync: every socket blocks in a thread of its own.
+static outcome run_sync(scenario const& s, std::vector<std::string> const& eps)
+{
+    typedef boost::asio::zmq::socket socket_t;
+
+    boost::asio::io_service ios;
+    boost::asio::zmq::context ctx;
+    ctx.set_io_threads(s.io_threads);
+
+    std::vector<std::unique_ptr<socket_t>> binders;
+    std::vector<std::unique_ptr<socket_t>> connecters;
+    std::vector<std::unique_ptr<perf::latency_recorder>> recorders;
+    bool reqrep = s.pattern == "reqrep";
+    for (int i = 0; i < s.pairs; ++i) {
+        binders.emplace_back(new socket_t(ios, ctx, reqrep ? ZMQ_REP : ZMQ_PULL));
+        binders.back()->bind(eps[i]);
+        connecters.emplace_back(new socket_t(ios, ctx, reqrep ? ZMQ_REQ : ZMQ_PUSH));
+        connecters.back()->connect(eps[i]);
+        recorders.emplace_back(new perf::latency_recorder());
+    }
+
+    int count = s.count;
+    int size = s.message_size;
+    std::vector<std::thread> threads;
+    auto start = bench_clock::now();
+    for (int i = 0; i < s.pairs; ++i) {
+        socket_t* b = binders[i].get();
+        socket_t* c = connecters[i].get();
+        perf::latency_recorder* latency = recorders[i].get();
+        if (reqrep) {
+            threads.emplace_back([b, count] {
+                for (int n = 0; n < count; ++n) b->write_frame(b->read_frame());
+            });
+            threads.emplace_back([c, count, size, latency] {
+                for (int n = 0; n < count; ++n) {
+                    latency->start();
+                    c->write_frame(boost::asio::zmq::frame(size));
+                    c->read_frame();
+                    latency->stop();
+                }
+            });
+        }
+        else {
+            threads.emplace_back([b, count] {
+                for (int n = 0; n < count; ++n) b->read_frame();
+            });
+            threads.emplace_back([c, count, size] {
+                for (int n = 0; n < count; ++n) c->write_frame(boost::asio::zmq::frame(size));
+            });
+        }
+    }
+    for (auto& t : threads) t.join();
+
+    outcome o{microseconds_since(start), boost::asio::zmq::histogram()};
+    if (reqrep)
+        for (auto const& r : recorders) o.latency.merge(r->results());
+    return o;
+}
+
+static void check(bool ok)
+{
+    if (!ok) throw boost::asio::zmq::exception();
+}
+
+//  poll: both ends of a pair in one thread, straight on libzmq.
+static void poll_pair(void* b, void* c, scenario const& s, perf::latency_recorder* latency)
+{
+    bool reqrep = s.pattern == "reqrep";
+    zmq_msg_t msg;
+    check(zmq_msg_init(&msg) == 0);
+
+    //  items[0] is the connecting end (PUSH or REQ), items[1] the binding end.
+    zmq_pollitem_t items[] = {{c, 0, ZMQ_POLLOUT, 0}, {b, 0, ZMQ_POLLIN, 0}};
+    int sent = 0;
+    int done = 0;
+    while (done < s.count) {
+        check(zmq_poll(items, 2, -1) >= 0);
+        if (items[0].revents & ZMQ_POLLIN) {
+            check(zmq_msg_recv(&msg, c, 0) >= 0);
+            latency->stop();
+            ++done;
+            items[0].events = done < s.count ? ZMQ_POLLOUT : 0;
+        }
+        else if (items[0].revents & ZMQ_POLLOUT) {
+            zmq_msg_t out;
+            check(zmq_msg_init_size(&out, s.message_size) == 0);
+            if (reqrep) latency->start();
+            check(zmq_msg_send(&out, c, 0) >= 0);
+            if (reqrep)
+                items[0].events = ZMQ_POLLIN;
+            else if (++sent == s.count)
+                items[0].events = 0;
+        }
+        if (items[1].revents & ZMQ_POLLIN) {
+            check(zmq_msg_recv(&msg, b, 0) >= 0);
+            if (reqrep)
+                items[1].events = ZMQ_POLLOUT;
+            else
+                ++done;
+        }
+        else if (items[1].revents & ZMQ_POLLOUT) {
+            check(zmq_msg_send(&msg, b, 0) >= 0);
+            items[1].events = ZMQ_POLLIN;
+        }
+    }
+    zmq_msg_close(&msg);
+}
+
+static outcome run_poll(scenario const& s, std::vector<std::string> const& eps)
+{
+    std::unique_ptr<void, boost::asio::zmq::context_deleter> ctx(zmq_ctx_new());
+    check(ctx != nullptr);
+    check(zmq_ctx_set(ctx.get(), ZMQ_IO_THREADS, s.io_threads) == 0);
+
+    bool reqrep = s.pattern == "reqrep";
+    std::vector<std::unique_ptr<void, boost::asio::zmq::socket_deleter>> binders;
+    std::vector<std::unique_ptr<void, boost::asio::zmq::socket_deleter>> connecters;
+    std::vector<std::unique_ptr<perf::latency_recorder>> recorders;
+    for (int i = 0; i < s.pairs; ++i) {
+        binders.emplace_back(zmq_socket(ctx.get(), reqrep ? ZMQ_REP : ZMQ_PULL));
+        check(binders.back() != nullptr && zmq_bind(binders.back().get(), eps[i].c_str()) == 0);
+        connecters.emplace_back(zmq_socket(ctx.get(), reqrep ? ZMQ_REQ : ZMQ_PUSH));
+        check(connecters.back() != nullptr &&
+              zmq_connect(connecters.back().get(), eps[i].c_str()) == 0);
+        recorders.emplace_back(new perf::latency_recorder());
+    }
+
+    std::vector<std::thread> threads;
+    auto start = bench_clock::now();
+    for (int i = 0; i < s.pairs; ++i)
+        threads.emplace_back(poll_pair, binders[i].get(), connecters[i].get(), std::cref(s),
+                             recorders[i].get());
+    for (auto& t : threads) t.join();
+
+    outcome o{microseconds_since(start), boost::asio::zmq::histogram()};
+    if (reqrep)
+        for (auto const& r : recorders) o.latency.merge(r->results());
+    return o;
+}
+
+static void write_result(std::ostream& os, scenario const& s, outcome const& o)
+{
+    double messages = static_cast<double>(s.count) * s.pairs;
+    double per_second = messages / o.elapsed_us * 1000000;
+
+    os << "{\"pattern\":\"" << s.pattern << "\",\"api\":\"" << s.api << "\",\"transport\":\""
+       << s.transport << "\",\"message_size\":" << s.message_size << ",\"count\":" << s.count
+       << ",\"io_threads\":" << s.io_threads << ",\"pairs\":" << s.pairs
+       << ",\"elapsed_us\":" << o.elapsed_us;
+    if (s.pattern == "pushpull") {
+        os << ",\"throughput_msg_s\":" << static_cast<unsigned long>(per_second)
+           << ",\"throughput_mb_s\":" << per_second * s.message_size * 8 / 1000000;
+    }
+    else {
+        //  Every pair runs its roundtrips one after the other, so the average
+        //  one-way latency is the time each pair took over twice its count.
+        perf::write_latency_fields(os, o.elapsed_us / (s.count * 2), o.latency);
+        os << ",\"roundtrips_s\":" << static_cast<unsigned long>(per_second);
+    }
+    os << "}";
+}
+
+int main(int argc, char* argv[])
+{
+    parameters p;
+    for (int i = 1; i < argc; ++i) {
+        if (!parse_argument(argv[i], p)) {
+            std::cerr << usage;
+            return 1;
+        }
+    }
+
+    std::vector<scenario> scenarios;
+    for (auto const& pattern : p.patterns)
+        for (auto const& api : p.apis)
+            for (auto const& transport : p.transports)
+                for (int io_threads : p.io_threads)
+                    for (int pairs : p.pairs)
+                        for (int size : p.sizes)
+                            for (int count : p.counts)
+                                scenarios.push_back(scenario{size, count, transport, pattern, api,
+                                                             io_threads, pairs});
+
+    std::cout << "[";
+    for (std::size_t i = 0; i < scenarios.size(); ++i) {
+        scenario const& s = scenarios[i];
+        std::cerr << "running " << s.pattern << " " << s.api << " " << s.transport << " size "
+                  << s.message_size << " count " << s.count << " io-threads " << s.io_threads
+                  << " pairs " << s.pairs << "\n";
+
+        std::vector<std::string> eps;
+        for (int n = 0; n < s.pairs; ++n) eps.push_back(perf::make_endpoint(s.transport, p.port));
+
+        outcome o = s.api == "async" ? run_async(s, eps)
+                    : s.api == "sync" ? run_sync(s, eps)
+                                      : run_poll(s, eps);
+
+        std::cout << (i == 0 ? "\n  " : ",\n  ");
+        write_result(std::cout, s, o);
+        std::cout.flush();
+    }
+    std::cout << "\n]\n";
+}
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <cstddef>
 #include <iterator>
 #include <string>
 #include <vector>
+#include <unistd.h>
 #include <boost/asio.hpp>
 #include <asio-zmq.hpp>
+#include "latency.hpp"
 
 namespace boost {
 namespace asio {
@@ -12,7 +15,20 @@ namespace zmq {
 namespace test {
 namespace perf {
 
-typedef std::vector<boost::asio::zmq::frame> message_t;
+typedef boost::asio::zmq::message message_t;
+
+//  A new inproc, ipc or tcp loopback endpoint on every call, so that a tcp
+//  port or ipc path is never reused while an earlier listener may linger.
+//  tcp ports count up from port.
+inline std::string make_endpoint(std::string const& transport, int port)
+{
+    static int next = 0;
+    int n = next++;
+    if (transport == "tcp") return "tcp://127.0.0.1:" + std::to_string(port + n);
+    if (transport == "ipc")
+        return "ipc:///tmp/asio_zmq_perf." + std::to_string(getpid()) + "." + std::to_string(n);
+    return "inproc://asio_zmq_perf." + std::to_string(n);
+}
 
 class requester {
 private:
@@ -20,34 +36,44 @@ private:
     message_t msg_;
     int rc_;
     int const message_size_;
+    latency_recorder* latency_;
+
+    void write()
+    {
+        if (latency_) latency_->start();
+        req_.async_write_message(msg_,
+                                 std::bind(&requester::handle_write, this, std::placeholders::_1));
+    }
 
     void handle_write(boost::system::error_code const& ec)
     {
         msg_.clear();
-        req_.async_read_message(std::back_inserter(msg_),
+        req_.async_read_message(msg_,
                                 std::bind(&requester::handle_read, this, std::placeholders::_1));
     }
 
     void handle_read(boost::system::error_code const& ec)
     {
+        if (latency_) latency_->stop();
         if (--rc_ == 0) return;
 
         msg_.clear();
         msg_.push_back(boost::asio::zmq::frame(message_size_));
-        req_.async_write_message(std::begin(msg_), std::end(msg_),
-                                 std::bind(&requester::handle_write, this, std::placeholders::_1));
+        write();
     }
 
 public:
+    //  With a recorder, every roundtrip is timed into it.
     requester(boost::asio::io_service& ios, boost::asio::zmq::context& ctx, int rc,
-              int message_size, std::string const& ep)
-        : req_(ios, ctx, ZMQ_REQ), msg_(), rc_(rc), message_size_(message_size)
+              int message_size, std::string const& ep,
+              completion_mode mode = completion_mode::post, latency_recorder* latency = nullptr)
+        : req_(ios, ctx, ZMQ_REQ), msg_(), rc_(rc), message_size_(message_size), latency_(latency)
     {
+        req_.set_completion_mode(mode);
         req_.connect(ep);
 
         msg_.push_back(boost::asio::zmq::frame(message_size_));
-        req_.async_write_message(std::begin(msg_), std::end(msg_),
-                                 std::bind(&requester::handle_write, this, std::placeholders::_1));
+        write();
     }
 };
 
@@ -62,24 +88,25 @@ private:
         if (--rc_ == 0) return;
 
         msg_.clear();
-        rep_.async_read_message(std::back_inserter(msg_),
+        rep_.async_read_message(msg_,
                                 std::bind(&replier::handle_read, this, std::placeholders::_1));
     }
 
     void handle_read(boost::system::error_code const& ec)
     {
-        rep_.async_write_message(std::begin(msg_), std::end(msg_),
+        rep_.async_write_message(msg_,
                                  std::bind(&replier::handle_write, this, std::placeholders::_1));
     }
 
 public:
     replier(boost::asio::io_service& ios, boost::asio::zmq::context& ctx, int rc,
-            std::string const& ep)
+            std::string const& ep, completion_mode mode = completion_mode::post)
         : rep_(ios, ctx, ZMQ_REP), msg_(), rc_(rc)
     {
+        rep_.set_completion_mode(mode);
         rep_.bind(ep);
 
-        rep_.async_read_message(std::back_inserter(msg_),
+        rep_.async_read_message(msg_,
                                 std::bind(&replier::handle_read, this, std::placeholders::_1));
     }
 };
@@ -90,26 +117,33 @@ private:
     int count_;
     int size_;
     message_t msg_;
+    boost::asio::zmq::frame_pool* pool_;
+
+    boost::asio::zmq::frame make_frame()
+    {
+        return pool_ ? pool_->make_frame(size_) : boost::asio::zmq::frame(size_);
+    }
 
     void handle_write(boost::system::error_code const& ec)
     {
         if (--count_ == 0) return;
 
         msg_.clear();
-        msg_.push_back(boost::asio::zmq::frame(size_));
-        pusher_.async_write_message(std::begin(msg_), std::end(msg_),
+        msg_.push_back(make_frame());
+        pusher_.async_write_message(msg_,
                                     std::bind(&pusher::handle_write, this, std::placeholders::_1));
     }
 
 public:
+    //  With a pool, every payload is taken from it instead of zmq_msg_init_size.
     explicit pusher(boost::asio::io_service& ios, boost::asio::zmq::context& ctx, int count,
-                    int size, std::string const& ep)
-        : pusher_(ios, ctx, ZMQ_PUSH), count_(count), size_(size), msg_()
+                    int size, std::string const& ep, boost::asio::zmq::frame_pool* pool = nullptr)
+        : pusher_(ios, ctx, ZMQ_PUSH), count_(count), size_(size), msg_(), pool_(pool)
     {
         pusher_.connect(ep);
 
-        msg_.push_back(boost::asio::zmq::frame(size_));
-        pusher_.async_write_message(std::begin(msg_), std::end(msg_),
+        msg_.push_back(make_frame());
+        pusher_.async_write_message(msg_,
                                     std::bind(&pusher::handle_write, this, std::placeholders::_1));
     }
 };
@@ -125,7 +159,7 @@ private:
         if (--count_ == 0) return;
 
         msg_.clear();
-        puller_.async_read_message(std::back_inserter(msg_),
+        puller_.async_read_message(msg_,
                                    std::bind(&puller::handle_read, this, std::placeholders::_1));
     }
 
@@ -135,11 +169,125 @@ public:
         : puller_(ios, ctx, ZMQ_PULL), count_(count), msg_()
     {
         puller_.bind(ep);
-        puller_.async_read_message(std::back_inserter(msg_),
+        puller_.async_read_message(msg_,
                                    std::bind(&puller::handle_read, this, std::placeholders::_1));
     }
 };
 
+class frame_pusher {
+private:
+    boost::asio::zmq::socket pusher_;
+    int count_;
+    int size_;
+
+    void handle_write(boost::system::error_code const& ec)
+    {
+        if (--count_ == 0) return;
+
+        pusher_.async_write_frame(
+            boost::asio::zmq::frame(size_), 0,
+            std::bind(&frame_pusher::handle_write, this, std::placeholders::_1));
+    }
+
+public:
+    frame_pusher(boost::asio::io_service& ios, boost::asio::zmq::context& ctx, int count, int size,
+                 std::string const& ep)
+        : pusher_(ios, ctx, ZMQ_PUSH), count_(count), size_(size)
+    {
+        pusher_.connect(ep);
+        pusher_.async_write_frame(
+            boost::asio::zmq::frame(size_), 0,
+            std::bind(&frame_pusher::handle_write, this, std::placeholders::_1));
+    }
+};
+
+//  Keeps up to window frames queued on the socket at once, starting a new
+//  write as each one completes.
+class pipelined_pusher {
+private:
+    boost::asio::zmq::socket pusher_;
+    int remaining_;
+    int size_;
+
+    void write()
+    {
+        --remaining_;
+        pusher_.async_write_frame(
+            boost::asio::zmq::frame(size_), 0,
+            std::bind(&pipelined_pusher::handle_write, this, std::placeholders::_1));
+    }
+
+    void handle_write(boost::system::error_code const& ec)
+    {
+        if (remaining_ > 0) write();
+    }
+
+public:
+    pipelined_pusher(boost::asio::io_service& ios, boost::asio::zmq::context& ctx, int count,
+                     int size, int window, std::string const& ep)
+        : pusher_(ios, ctx, ZMQ_PUSH), remaining_(count), size_(size)
+    {
+        pusher_.connect(ep);
+        for (int i = 0; i < window && remaining_ > 0; ++i) write();
+    }
+};
+
+class frame_puller {
+private:
+    boost::asio::zmq::socket puller_;
+    int count_;
+    boost::asio::zmq::frame frame_;
+
+    void handle_read(boost::system::error_code const& ec, bool more)
+    {
+        if (--count_ == 0) return;
+
+        puller_.async_read_frame(frame_, std::bind(&frame_puller::handle_read, this,
+                                                   std::placeholders::_1, std::placeholders::_2));
+    }
+
+public:
+    frame_puller(boost::asio::io_service& ios, boost::asio::zmq::context& ctx, int count,
+                 std::string const& ep)
+        : puller_(ios, ctx, ZMQ_PULL), count_(count), frame_()
+    {
+        puller_.bind(ep);
+        puller_.async_read_frame(frame_, std::bind(&frame_puller::handle_read, this,
+                                                   std::placeholders::_1, std::placeholders::_2));
+    }
+};
+
+class batch_puller {
+private:
+    boost::asio::zmq::socket puller_;
+    int count_;
+    std::size_t batch_size_;
+    std::vector<message_t> msgs_;
+
+    void handle_read(boost::system::error_code const& ec, std::size_t n)
+    {
+        count_ -= static_cast<int>(n);
+        if (ec || count_ <= 0) return;
+
+        msgs_.clear();
+        puller_.async_read_messages(msgs_, batch_size_,
+                                    std::bind(&batch_puller::handle_read, this,
+                                              std::placeholders::_1, std::placeholders::_2));
+    }
+
+public:
+    batch_puller(boost::asio::io_service& ios, boost::asio::zmq::context& ctx, int count,
+                 std::size_t batch_size, std::string const& ep)
+        : puller_(ios, ctx, ZMQ_PULL), count_(count), batch_size_(batch_size), msgs_()
+    {
+        puller_.bind(ep);
+        msgs_.reserve(batch_size_);
+        puller_.async_read_messages(msgs_, batch_size_,
+                                    std::bind(&batch_puller::handle_read, this,
+                                              std::placeholders::_1, std::placeholders::_2));
+    }
+};
+
 }  // namespace perf
 }  // namespace test
 }  // namespace zmq
@@ -0,0 +1,108 @@
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <boost/asio.hpp>
+#include <asio-zmq.hpp>
+#include "helper.hpp"
+
+//  Counts every operator new in the process, including those made inside
+//  Asio while it queues the socket's handlers. The whole replaceable set is
+//  replaced, so that every form of new is counted and every form of delete
+//  frees memory from the same allocator.
+static std::atomic<unsigned long> allocations(0);
+
+static void* counted_allocate(std::size_t size) noexcept
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+//  Kept out of line: once inlined into a delete expression, GCC sees free()
+//  applied to a pointer from operator new and warns about the mismatch.
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+static void counted_deallocate(void* p) noexcept
+{
+    std::free(p);
+}
+
+void* operator new(std::size_t size)
+{
+    if (void* p = counted_allocate(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    if (void* p = counted_allocate(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept
+{
+    return counted_allocate(size);
+}
+
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept
+{
+    return counted_allocate(size);
+}
+
+void operator delete(void* p) noexcept { counted_deallocate(p); }
+
+void operator delete[](void* p) noexcept { counted_deallocate(p); }
+
+void operator delete(void* p, std::size_t) noexcept { counted_deallocate(p); }
+
+void operator delete[](void* p, std::size_t) noexcept { counted_deallocate(p); }
+
+void operator delete(void* p, std::nothrow_t const&) noexcept { counted_deallocate(p); }
+
+void operator delete[](void* p, std::nothrow_t const&) noexcept { counted_deallocate(p); }
+
+//  Runs message_count messages through a push/pull pair and returns the
+//  number of allocations made while doing so.
+static unsigned long run(boost::asio::zmq::context& ctx, std::string const& ep, int message_size,
+                         int message_count)
+{
+    boost::asio::io_service ios;
+    boost::asio::zmq::test::perf::puller pl(ios, ctx, message_count, ep);
+    boost::asio::zmq::test::perf::pusher ps(ios, ctx, message_count, message_size, ep);
+
+    //  Let the first few round-trips through the reactor fill the caches.
+    ios.run_one();
+    ios.run_one();
+
+    unsigned long before = allocations.load();
+    ios.run();
+    return allocations.load() - before;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        std::cerr << "usage: inproc_alloc <message-size> <message-count>\n";
+        return 1;
+    }
+
+    int message_size = std::atoi(argv[1]);
+    int message_count = std::atoi(argv[2]);
+
+    std::cout << "message size: " << message_size << " [B]\n";
+    std::cout << "message count: " << message_count << "\n";
+
+    boost::asio::zmq::context ctx;
+
+    //  The first run pays for the io_service, reactor and socket setup.
+    run(ctx, "inproc://alloc_warmup", message_size, message_count);
+    unsigned long count = run(ctx, "inproc://alloc_test", message_size, message_count);
+
+    std::cout << "allocations: " << count << "\n";
+    std::cout << "allocations per message: "
+              << static_cast<double>(count) / static_cast<double>(message_count) << "\n";
+
+    return count < static_cast<unsigned long>(message_count) / 100 ? 0 : 1;
+}
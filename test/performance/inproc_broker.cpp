@@ -0,0 +1,172 @@
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <boost/asio.hpp>
+#include <asio-zmq.hpp>
+
+//  A producer thread pushes into the broker's frontend and a consumer thread
+//  pulls from its backend; the broker forwards on its own thread. The time
+//  runs from the first message sent to the last one received.
+
+static char const* const in_ep = "inproc://broker_in";
+static char const* const out_ep = "inproc://broker_out";
+
+//  The read-then-write forwarding loop of the rrbroker and asyncsrv examples.
+class handwritten_broker {
+private:
+    boost::asio::zmq::socket& frontend_;
+    boost::asio::zmq::socket& backend_;
+    boost::asio::zmq::message msg_;
+
+    void handle_read(boost::system::error_code const& ec)
+    {
+        if (ec) return;
+        backend_.async_write_message(msg_, std::bind(&handwritten_broker::handle_write, this,
+                                                     std::placeholders::_1));
+    }
+
+    void handle_write(boost::system::error_code const& ec)
+    {
+        if (ec) return;
+        msg_.clear();
+        frontend_.async_read_message(msg_, std::bind(&handwritten_broker::handle_read, this,
+                                                     std::placeholders::_1));
+    }
+
+public:
+    handwritten_broker(boost::asio::zmq::socket& frontend, boost::asio::zmq::socket& backend)
+        : frontend_(frontend), backend_(backend), msg_()
+    {
+        frontend_.async_read_message(msg_, std::bind(&handwritten_broker::handle_read, this,
+                                                     std::placeholders::_1));
+    }
+};
+
+static long run_asio(int message_size, int message_count, bool builtin)
+{
+    boost::asio::io_service ios;
+    boost::asio::zmq::context ctx;
+    boost::asio::zmq::socket frontend(ios, ctx, ZMQ_PULL);
+    boost::asio::zmq::socket backend(ios, ctx, ZMQ_PUSH);
+    boost::asio::zmq::socket producer(ios, ctx, ZMQ_PUSH);
+    boost::asio::zmq::socket consumer(ios, ctx, ZMQ_PULL);
+    frontend.bind(in_ep);
+    backend.bind(out_ep);
+    producer.connect(in_ep);
+    consumer.connect(out_ep);
+
+    boost::asio::zmq::proxy proxy(frontend, backend);
+    std::unique_ptr<handwritten_broker> handwritten;
+    if (builtin)
+        proxy.async_run([](boost::system::error_code const&) {});
+    else
+        handwritten.reset(new handwritten_broker(frontend, backend));
+
+    boost::asio::io_service::work work(ios);
+    std::thread broker([&ios] { ios.run(); });
+
+    auto watch = std::chrono::system_clock::now();
+
+    std::thread sender([&producer, message_size, message_count] {
+        for (int i = 0; i < message_count; ++i)
+            producer.write_frame(boost::asio::zmq::frame(message_size));
+    });
+    for (int i = 0; i < message_count; ++i) consumer.read_frame();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::system_clock::now() - watch).count();
+
+    sender.join();
+    ios.stop();
+    broker.join();
+    return elapsed;
+}
+
+//  The same pipeline built on raw libzmq around zmq_proxy_steerable.
+static long run_zmq_proxy(int message_size, int message_count)
+{
+    void* ctx = zmq_ctx_new();
+    void* frontend = zmq_socket(ctx, ZMQ_PULL);
+    void* backend = zmq_socket(ctx, ZMQ_PUSH);
+    void* control = zmq_socket(ctx, ZMQ_PAIR);
+    void* steer = zmq_socket(ctx, ZMQ_PAIR);
+    void* producer = zmq_socket(ctx, ZMQ_PUSH);
+    void* consumer = zmq_socket(ctx, ZMQ_PULL);
+    zmq_bind(frontend, in_ep);
+    zmq_bind(backend, out_ep);
+    zmq_bind(control, "inproc://broker_control");
+    zmq_connect(steer, "inproc://broker_control");
+    zmq_connect(producer, in_ep);
+    zmq_connect(consumer, out_ep);
+
+    std::thread broker([=] { zmq_proxy_steerable(frontend, backend, nullptr, control); });
+
+    auto watch = std::chrono::system_clock::now();
+
+    std::thread sender([=] {
+        zmq_msg_t msg;
+        for (int i = 0; i < message_count; ++i) {
+            zmq_msg_init_size(&msg, message_size);
+            zmq_msg_send(&msg, producer, 0);
+        }
+    });
+    zmq_msg_t msg;
+    zmq_msg_init(&msg);
+    for (int i = 0; i < message_count; ++i) zmq_msg_recv(&msg, consumer, 0);
+    zmq_msg_close(&msg);
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::system_clock::now() - watch).count();
+
+    sender.join();
+    zmq_send(steer, "TERMINATE", 9, 0);
+    broker.join();
+
+    for (void* s : {frontend, backend, control, steer, producer, consumer}) {
+        int linger = 0;
+        zmq_setsockopt(s, ZMQ_LINGER, &linger, sizeof(linger));
+        zmq_close(s);
+    }
+    zmq_ctx_term(ctx);
+    return elapsed;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 4) {
+        std::cerr << "usage: inproc_broker <message-size> <message-count> "
+                     "<proxy|handwritten|zmq_proxy>\n";
+        return 1;
+    }
+
+    int message_size = std::atoi(argv[1]);
+    int message_count = std::atoi(argv[2]);
+    std::string mode = argv[3];
+
+    long elapsed;
+    if (mode == "proxy")
+        elapsed = run_asio(message_size, message_count, true);
+    else if (mode == "handwritten")
+        elapsed = run_asio(message_size, message_count, false);
+    else if (mode == "zmq_proxy")
+        elapsed = run_zmq_proxy(message_size, message_count);
+    else {
+        std::cerr << "inproc_broker: unknown broker " << mode << "\n";
+        return 1;
+    }
+
+    std::cout << "message size: " << message_size << " [B]\n";
+    std::cout << "message count: " << message_count << "\n";
+    std::cout << "broker: " << mode << "\n";
+
+    unsigned long throughput =
+        static_cast<double>(message_count) / static_cast<double>(elapsed) * 1000000;
+    double megabits = static_cast<double>(throughput * message_size * 8) / 1000000;
+
+    std::cout << "mean throughput: " << throughput << " [msg/s]\n";
+    std::cout << "mean throughput: " << megabits << " [Mb/s]\n";
+}
@@ -1,5 +1,6 @@
 #include <chrono>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <boost/asio.hpp>
@@ -10,31 +11,45 @@ static std::string const ep = "inproc://lat_test";
 
 int main(int argc, char* argv[])
 {
-    if (argc != 3) {
-        std::cerr << "usage: inproc_lat <message-size> <roundtrip-count>\n";
+    auto format = boost::asio::zmq::test::perf::take_report_format(argc, argv);
+    if ((argc != 3 && argc != 4) ||
+        (argc == 4 && std::strcmp(argv[3], "post") != 0 && std::strcmp(argv[3], "dispatch") != 0)) {
+        std::cerr << "usage: inproc_lat <message-size> <roundtrip-count> [post|dispatch] "
+                  << "[text|json|csv]\n";
         return 1;
     }
 
     int message_size = std::atoi(argv[1]);
     int roundtrip_count = std::atoi(argv[2]);
-
-    std::cout << "message size: " << message_size << " [B]\n";
-    std::cout << "roundtrip count: " << roundtrip_count << "\n";
+    auto mode = argc == 4 && std::strcmp(argv[3], "dispatch") == 0
+                    ? boost::asio::zmq::completion_mode::dispatch
+                    : boost::asio::zmq::completion_mode::post;
+
+    if (format == boost::asio::zmq::test::perf::report_format::text) {
+        std::cout << "message size: " << message_size << " [B]\n";
+        std::cout << "roundtrip count: " << roundtrip_count << "\n";
+        std::cout << "completion mode: "
+                  << (mode == boost::asio::zmq::completion_mode::dispatch ? "dispatch" : "post")
+                  << "\n";
+    }
 
     boost::asio::io_service ios;
     boost::asio::zmq::context ctx;
+    boost::asio::zmq::test::perf::latency_recorder latency;
 
     auto watch = std::chrono::system_clock::now();
 
-    boost::asio::zmq::test::perf::replier rep(ios, ctx, roundtrip_count, ep);
-    boost::asio::zmq::test::perf::requester req(ios, ctx, roundtrip_count, message_size, ep);
+    boost::asio::zmq::test::perf::replier rep(ios, ctx, roundtrip_count, ep, mode);
+    boost::asio::zmq::test::perf::requester req(ios, ctx, roundtrip_count, message_size, ep,
+                                                mode, &latency);
 
     ios.run();
 
     auto elapsed = std::chrono::system_clock::now() - watch;
-    double latency = static_cast<double>(
+    double average = static_cast<double>(
                          std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()) /
                      (roundtrip_count * 2);
 
-    std::cout << "average latency: " << latency << " [us]\n";
-}
\ No newline at end of file
+    boost::asio::zmq::test::perf::report_latency(format, "inproc_lat", message_size,
+                                                 roundtrip_count, average, latency.results());
+}
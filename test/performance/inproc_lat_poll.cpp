@@ -3,6 +3,7 @@
 #include <string.h>
 #include <zmq.h>
 #include <zmq_utils.h>
+#include "latency.hpp"
 
 int main(int argc, char* argv[])
 {
@@ -16,10 +17,13 @@ int main(int argc, char* argv[])
     zmq_msg_t msg;
     void* watch;
     unsigned long elapsed;
-    double latency;
+    double average;
+    boost::asio::zmq::test::perf::report_format format;
+    boost::asio::zmq::test::perf::latency_recorder latency;
 
+    format = boost::asio::zmq::test::perf::take_report_format(argc, argv);
     if (argc != 3) {
-        printf("usage: inproc_lat <message-size> <roundtrip-count>\n");
+        printf("usage: inproc_lat <message-size> <roundtrip-count> [text|json|csv]\n");
         return 1;
     }
 
@@ -58,8 +62,10 @@ int main(int argc, char* argv[])
 
     zmq_pollitem_t items[] = {{req, 0, ZMQ_POLLOUT, 0}, {rep, 0, ZMQ_POLLIN, 0}};
 
-    printf("message size: %d [B]\n", (int)message_size);
-    printf("roundtrip count: %d\n", (int)roundtrip_count);
+    if (format == boost::asio::zmq::test::perf::report_format::text) {
+        printf("message size: %d [B]\n", (int)message_size);
+        printf("roundtrip count: %d\n", (int)roundtrip_count);
+    }
 
     if (zmq_msg_init_size(&msg, message_size) != 0) {
         printf("error in zmq_msg_init: %s\n", zmq_strerror(errno));
@@ -76,9 +82,11 @@ int main(int argc, char* argv[])
                 printf("error in zmq_msg_recv: %s\n", zmq_strerror(errno));
                 exit(1);
             }
+            latency.stop();
             items[0].events = ZMQ_POLLOUT;
         }
         if ((items[0].revents & ZMQ_POLLOUT) == ZMQ_POLLOUT) {
+            latency.start();
             if (zmq_msg_send(&msg, req, 0) < 0) {
                 printf("error in zmq_msg_send: %s\n", zmq_strerror(errno));
                 exit(1);
@@ -106,9 +114,10 @@ int main(int argc, char* argv[])
 
     zmq_msg_close(&msg);
 
-    latency = (double)elapsed / (roundtrip_count * 2);
+    average = (double)elapsed / (roundtrip_count * 2);
 
-    printf("average latency: %.3f [us]\n", (double)latency);
+    boost::asio::zmq::test::perf::report_latency(format, "inproc_lat_poll", (int)message_size,
+                                                 roundtrip_count, average, latency.results());
 
     rc = zmq_close(req);
     if (rc != 0) {
@@ -5,39 +5,46 @@
 #include <thread>
 #include <boost/asio.hpp>
 #include <asio-zmq.hpp>
+#include "latency.hpp"
 
 static std::string const ep = "inproc://lat_test";
 static boost::asio::io_service ios;
 static boost::asio::zmq::context ctx;
 
-void requester(int rc, int msize)
+void requester(int rc, int msize, boost::asio::zmq::test::perf::latency_recorder* latency)
 {
     boost::asio::zmq::socket req(ios, ctx, ZMQ_REQ);
     req.connect(ep);
 
     while (--rc >= 0) {
+        latency->start();
         req.write_frame(boost::asio::zmq::frame(msize));
         req.read_frame();
+        latency->stop();
     }
 }
 
 int main(int argc, char* argv[])
 {
+    auto format = boost::asio::zmq::test::perf::take_report_format(argc, argv);
     if (argc != 3) {
-        std::cerr << "usage: inproc_lat <message-size> <roundtrip-count>\n";
+        std::cerr << "usage: inproc_lat <message-size> <roundtrip-count> [text|json|csv]\n";
         return 1;
     }
 
     int message_size = std::atoi(argv[1]);
     int roundtrip_count = std::atoi(argv[2]);
 
-    std::cout << "message size: " << message_size << " [B]\n";
-    std::cout << "roundtrip count: " << roundtrip_count << "\n";
+    if (format == boost::asio::zmq::test::perf::report_format::text) {
+        std::cout << "message size: " << message_size << " [B]\n";
+        std::cout << "roundtrip count: " << roundtrip_count << "\n";
+    }
 
     boost::asio::zmq::socket rep(ios, ctx, ZMQ_REP);
     rep.bind(ep);
 
-    std::thread worker(std::bind(requester, roundtrip_count, message_size));
+    boost::asio::zmq::test::perf::latency_recorder latency;
+    std::thread worker(std::bind(requester, roundtrip_count, message_size, &latency));
 
     auto watch = std::chrono::system_clock::now();
 
@@ -45,9 +52,10 @@ int main(int argc, char* argv[])
 
     auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
                        std::chrono::system_clock::now() - watch).count();
-    double latency = static_cast<double>(elapsed) / (roundtrip_count * 2);
-
-    std::cout << "average latency: " << latency << " [us]\n";
+    double average = static_cast<double>(elapsed) / (roundtrip_count * 2);
 
     worker.join();
+
+    boost::asio::zmq::test::perf::report_latency(format, "inproc_lat_sync", message_size,
+                                                 roundtrip_count, average, latency.results());
 }
@@ -0,0 +1,222 @@
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+#include <boost/asio.hpp>
+#include <asio-zmq.hpp>
+
+//  Request-reply through a least-recently-used broker, all on one io_service.
+//  Every client keeps one request in flight; every worker echoes.
+
+static std::string const front_ep = "inproc://lb_front";
+static std::string const back_ep = "inproc://lb_back";
+
+typedef boost::asio::zmq::message message_t;
+
+class client {
+private:
+    static int active_;
+
+    boost::asio::io_service& ios_;
+    boost::asio::zmq::socket req_;
+    message_t msg_;
+    int remaining_;
+
+    void write()
+    {
+        msg_.clear();
+        msg_.push_back(boost::asio::zmq::frame(std::string("request")));
+        req_.async_write_message(msg_, std::bind(&client::handle_write, this,
+                                                 std::placeholders::_1));
+    }
+
+    void handle_write(boost::system::error_code const& ec)
+    {
+        msg_.clear();
+        req_.async_read_message(msg_, std::bind(&client::handle_read, this,
+                                                std::placeholders::_1));
+    }
+
+    void handle_read(boost::system::error_code const& ec)
+    {
+        if (--remaining_ > 0)
+            write();
+        else if (--active_ == 0)
+            ios_.stop();
+    }
+
+public:
+    client(boost::asio::io_service& ios, boost::asio::zmq::context& ctx, int requests)
+        : ios_(ios), req_(ios, ctx, ZMQ_REQ), msg_(), remaining_(requests)
+    {
+        ++active_;
+        req_.connect(front_ep);
+        write();
+    }
+};
+
+int client::active_ = 0;
+
+class worker {
+private:
+    boost::asio::zmq::socket req_;
+    message_t msg_;
+
+    void handle_write(boost::system::error_code const& ec)
+    {
+        if (ec) return;
+        msg_.clear();
+        req_.async_read_message(msg_, std::bind(&worker::handle_read, this,
+                                                std::placeholders::_1));
+    }
+
+    void handle_read(boost::system::error_code const& ec)
+    {
+        if (ec) return;
+        req_.async_write_message(msg_, std::bind(&worker::handle_write, this,
+                                                 std::placeholders::_1));
+    }
+
+public:
+    worker(boost::asio::io_service& ios, boost::asio::zmq::context& ctx)
+        : req_(ios, ctx, ZMQ_REQ), msg_()
+    {
+        req_.connect(back_ep);
+        msg_.push_back(boost::asio::zmq::frame(std::string("READY")));
+        req_.async_write_message(msg_, std::bind(&worker::handle_write, this,
+                                                 std::placeholders::_1));
+    }
+};
+
+//  The structure of the lbbroker example before lb_broker: ready workers in
+//  a std::queue of string copies of their ids, one read per message.
+class handwritten_broker {
+private:
+    typedef std::shared_ptr<message_t> message_ptr;
+
+    boost::asio::zmq::socket& frontend_;
+    boost::asio::zmq::socket& backend_;
+    std::queue<std::string> worker_queue_;
+    bool reading_frontend_;
+
+    void read_backend()
+    {
+        message_ptr buff{new message_t};
+        backend_.async_read_message(*buff, std::bind(&handwritten_broker::handle_worker_ready,
+                                                     this, std::placeholders::_1, buff));
+    }
+
+    void read_frontend()
+    {
+        if (reading_frontend_ || worker_queue_.empty()) return;
+        reading_frontend_ = true;
+        message_ptr buff{new message_t};
+        frontend_.async_read_message(*buff,
+                                     std::bind(&handwritten_broker::handle_client_requested, this,
+                                               std::placeholders::_1, buff));
+    }
+
+    void handle_worker_ready(boost::system::error_code const& ec, message_ptr buff)
+    {
+        if (ec) return;
+        worker_queue_.push(std::to_string(buff->front()));
+        if (buff->size() == 5)
+            frontend_.async_write_message(
+                std::begin(*buff) + 2, std::end(*buff),
+                std::bind(&handwritten_broker::null_handler, this, std::placeholders::_1, buff));
+        read_frontend();
+        read_backend();
+    }
+
+    void handle_client_requested(boost::system::error_code const& ec, message_ptr buff)
+    {
+        reading_frontend_ = false;
+        if (ec) return;
+        buff->push_envelope(boost::asio::zmq::frame(worker_queue_.front()));
+        worker_queue_.pop();
+        backend_.async_write_message(
+            *buff,
+            std::bind(&handwritten_broker::null_handler, this, std::placeholders::_1, buff));
+        read_frontend();
+    }
+
+    void null_handler(boost::system::error_code const& ec, message_ptr buff) {}
+
+public:
+    handwritten_broker(boost::asio::zmq::socket& frontend, boost::asio::zmq::socket& backend)
+        : frontend_(frontend), backend_(backend), worker_queue_(), reading_frontend_(false)
+    {
+        read_backend();
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    if (argc != 5) {
+        std::cerr << "usage: inproc_lbbroker <workers> <clients> <requests-per-client> "
+                     "<lb_broker|handwritten>\n";
+        return 1;
+    }
+
+    int worker_count = std::atoi(argv[1]);
+    int client_count = std::atoi(argv[2]);
+    int request_count = std::atoi(argv[3]);
+    std::string mode = argv[4];
+
+    if (mode != "lb_broker" && mode != "handwritten") {
+        std::cerr << "inproc_lbbroker: unknown broker " << mode << "\n";
+        return 1;
+    }
+
+    std::cout << "workers: " << worker_count << "\n";
+    std::cout << "clients: " << client_count << "\n";
+    std::cout << "requests: " << request_count << " per client\n";
+    std::cout << "broker: " << mode << "\n";
+
+    boost::asio::io_service ios;
+    boost::asio::zmq::context ctx;
+    ctx.set_max_sockets(worker_count + client_count + 16);
+
+    boost::asio::zmq::socket frontend(ios, ctx, ZMQ_ROUTER);
+    boost::asio::zmq::socket backend(ios, ctx, ZMQ_ROUTER);
+    frontend.bind(front_ep);
+    backend.bind(back_ep);
+
+    boost::asio::zmq::lb_broker broker(frontend, backend, worker_count);
+    std::unique_ptr<handwritten_broker> handwritten;
+    if (mode == "lb_broker")
+        broker.async_run([](boost::system::error_code const&) {});
+    else
+        handwritten.reset(new handwritten_broker(frontend, backend));
+
+    std::vector<std::unique_ptr<worker>> workers;
+    for (int i = 0; i < worker_count; ++i) workers.emplace_back(new worker(ios, ctx));
+
+    //  Let every worker announce itself before the clients start.
+    while (ios.poll() > 0) {
+    }
+
+    auto watch = std::chrono::system_clock::now();
+
+    std::vector<std::unique_ptr<client>> clients;
+    for (int i = 0; i < client_count; ++i)
+        clients.emplace_back(new client(ios, ctx, request_count));
+
+    ios.run();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::system_clock::now() - watch).count();
+    double total = static_cast<double>(client_count) * request_count;
+    unsigned long throughput = total / static_cast<double>(elapsed) * 1000000;
+
+    std::cout << "mean throughput: " << throughput << " [req/s]\n";
+    if (mode == "lb_broker") {
+        boost::asio::zmq::lb_broker_statistics stats = broker.statistics();
+        std::cout << "known workers: " << stats.known_workers << "\n";
+        std::cout << "peak ready workers: " << stats.peak_ready_workers << "\n";
+    }
+}
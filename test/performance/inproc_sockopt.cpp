@@ -0,0 +1,131 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dlfcn.h>
+#include <boost/asio.hpp>
+#include <asio-zmq.hpp>
+#include "helper.hpp"
+
+//  Counts the libzmq calls made on the hot path by interposing the
+//  executable's own definitions in front of the shared library's.
+static std::atomic<unsigned long> getsockopt_calls(0);
+static std::atomic<unsigned long> recv_calls(0);
+static std::atomic<unsigned long> send_calls(0);
+
+template <typename Function> static Function* next_symbol(char const* name)
+{
+    return reinterpret_cast<Function*>(dlsym(RTLD_NEXT, name));
+}
+
+extern "C" {
+
+int zmq_getsockopt(void* s, int option, void* optval, size_t* optvallen)
+{
+    typedef int function_type(void*, int, void*, size_t*);
+    static function_type* real = next_symbol<function_type>("zmq_getsockopt");
+    getsockopt_calls.fetch_add(1, std::memory_order_relaxed);
+    return real(s, option, optval, optvallen);
+}
+
+int zmq_msg_recv(zmq_msg_t* msg, void* s, int flags)
+{
+    typedef int function_type(zmq_msg_t*, void*, int);
+    static function_type* real = next_symbol<function_type>("zmq_msg_recv");
+    recv_calls.fetch_add(1, std::memory_order_relaxed);
+    return real(msg, s, flags);
+}
+
+int zmq_msg_send(zmq_msg_t* msg, void* s, int flags)
+{
+    typedef int function_type(zmq_msg_t*, void*, int);
+    static function_type* real = next_symbol<function_type>("zmq_msg_send");
+    send_calls.fetch_add(1, std::memory_order_relaxed);
+    return real(msg, s, flags);
+}
+}
+
+static void reset()
+{
+    getsockopt_calls = 0;
+    recv_calls = 0;
+    send_calls = 0;
+}
+
+static void report(std::string const& name, int message_count)
+{
+    double n = static_cast<double>(message_count);
+    std::cout << name << ": " << getsockopt_calls / n << " getsockopt, " << recv_calls / n
+              << " recv, " << send_calls / n << " send [calls/msg]\n";
+}
+
+//  Blocking reader: the producer runs on its own thread so that the calls
+//  counted while it is running belong to both sides.
+static void sync_read(boost::asio::zmq::context& ctx, int frame_count, int message_count)
+{
+    std::string const ep = "inproc://sockopt_sync";
+    boost::asio::io_service ios;
+    boost::asio::zmq::socket puller(ios, ctx, ZMQ_PULL);
+    puller.bind(ep);
+
+    std::thread worker([&ctx, &ep, frame_count, message_count] {
+        boost::asio::io_service ios;
+        boost::asio::zmq::socket pusher(ios, ctx, ZMQ_PUSH);
+        pusher.connect(ep);
+        std::vector<boost::asio::zmq::frame> msg;
+        for (int i = 0; i < message_count; ++i) {
+            msg.clear();
+            for (int j = 0; j < frame_count; ++j) msg.push_back(boost::asio::zmq::frame(1));
+            pusher.write_message(std::begin(msg), std::end(msg));
+        }
+    });
+
+    std::vector<boost::asio::zmq::frame> msg;
+    for (int i = 0; i < message_count; ++i) {
+        msg.clear();
+        puller.read_message(std::back_inserter(msg));
+    }
+    worker.join();
+}
+
+//  Asynchronous pusher and puller sharing one io_service.
+static void async_read(boost::asio::zmq::context& ctx, int message_count)
+{
+    std::string const ep = "inproc://sockopt_async";
+    boost::asio::io_service ios;
+    boost::asio::zmq::test::perf::puller pl(ios, ctx, message_count, ep);
+    boost::asio::zmq::test::perf::pusher ps(ios, ctx, message_count, 1, ep);
+    ios.run();
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        std::cerr << "usage: inproc_sockopt <frame-count> <message-count>\n";
+        return 1;
+    }
+
+    int frame_count = std::atoi(argv[1]);
+    int message_count = std::atoi(argv[2]);
+
+    std::cout << "frame count: " << frame_count << "\n";
+    std::cout << "message count: " << message_count << "\n";
+
+    boost::asio::zmq::context ctx;
+
+    reset();
+    sync_read(ctx, frame_count, message_count);
+    report("sync write_message/read_message", message_count);
+
+    reset();
+    async_read(ctx, message_count);
+    report("async_write_message/async_read_message", message_count);
+}
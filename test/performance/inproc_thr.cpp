@@ -1,9 +1,11 @@
 #include <chrono>
 #include <cstdlib>
+#include <functional>
 #include <iostream>
 #include <iterator>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 #include <boost/asio.hpp>
 #include <asio-zmq.hpp>
@@ -11,24 +13,54 @@
 
 static std::string const ep = "inproc://thr_test";
 
+//  Blocking producer used by the batched variant, so that the receiving
+//  io_service can fall behind and find several messages queued per wakeup.
+static void sync_pusher(boost::asio::zmq::context& ctx, int count, int msize)
+{
+    boost::asio::io_service ios;
+    boost::asio::zmq::socket s(ios, ctx, ZMQ_PUSH);
+    s.connect(ep);
+
+    while (--count >= 0) s.write_frame(boost::asio::zmq::frame(msize));
+}
+
 int main(int argc, char* argv[])
 {
-    if (argc != 3) {
-        std::cerr << "usage: inproc_thr <message-size> <message-count>\n";
+    if (argc != 3 && argc != 4) {
+        std::cerr << "usage: inproc_thr <message-size> <message-count> [batch-size]\n";
         return 1;
     }
 
     int message_size = std::atoi(argv[1]);
     int message_count = std::atoi(argv[2]);
+    bool batched = argc == 4;
+    int batch_size = batched ? std::atoi(argv[3]) : 0;
 
     std::cout << "message size: " << message_size << " [B]\n";
     std::cout << "message count: " << message_count << "\n";
+    if (batched) std::cout << "batch size: " << batch_size << "\n";
 
     boost::asio::io_service ios;
     boost::asio::zmq::context ctx;
 
-    boost::asio::zmq::test::perf::puller pl(ios, ctx, message_count, ep);
-    boost::asio::zmq::test::perf::pusher ps(ios, ctx, message_count, message_size, ep);
+    std::unique_ptr<boost::asio::zmq::test::perf::puller> pl;
+    std::unique_ptr<boost::asio::zmq::test::perf::batch_puller> bpl;
+    std::unique_ptr<boost::asio::zmq::test::perf::pusher> ps;
+    std::thread worker;
+
+    //  batch-size 0 keeps the one-message-per-wakeup puller as a baseline
+    //  against the same producer.
+    if (batch_size > 0)
+        bpl.reset(new boost::asio::zmq::test::perf::batch_puller(ios, ctx, message_count,
+                                                                  batch_size, ep));
+    else
+        pl.reset(new boost::asio::zmq::test::perf::puller(ios, ctx, message_count, ep));
+
+    if (batched)
+        worker = std::thread(sync_pusher, std::ref(ctx), message_count, message_size);
+    else
+        ps.reset(new boost::asio::zmq::test::perf::pusher(ios, ctx, message_count, message_size,
+                                                          ep));
 
     auto watch = std::chrono::system_clock::now();
 
@@ -42,4 +74,6 @@ int main(int argc, char* argv[])
 
     std::cout << "mean throughput: " << throughput << " [msg/s]\n";
     std::cout << "mean throughput: " << megabits << " [Mb/s]\n";
+
+    if (worker.joinable()) worker.join();
 }
\ No newline at end of file
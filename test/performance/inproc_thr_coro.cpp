@@ -0,0 +1,146 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <boost/asio.hpp>
+#include <asio-zmq.hpp>
+#include "helper.hpp"
+
+#if defined(BOOST_ASIO_HAS_CO_AWAIT)
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+using boost::asio::awaitable;
+using boost::asio::use_awaitable;
+
+static awaitable<void> push(boost::asio::zmq::socket& s, int count, int size)
+{
+    boost::asio::zmq::message msg;
+    while (--count >= 0) {
+        msg.clear();
+        msg.push_back(boost::asio::zmq::frame(size));
+        co_await s.async_write_message(msg, use_awaitable);
+    }
+}
+
+static awaitable<void> pull(boost::asio::zmq::socket& s, int count)
+{
+    boost::asio::zmq::message msg;
+    while (--count >= 0) {
+        msg.clear();
+        co_await s.async_read_message(msg, use_awaitable);
+    }
+}
+
+//  Asio's own cost of an operation awaited by a coroutine rather than completed
+//  through a callback: two chains of posts taking turns, like the pusher and
+//  the puller, driven each way.
+static awaitable<void> repost(int count)
+{
+    while (--count >= 0) co_await boost::asio::post(use_awaitable);
+}
+
+struct reposter {
+    boost::asio::io_service* ios;
+    int count;
+
+    void operator()()
+    {
+        if (--count >= 0) boost::asio::post(*ios, *this);
+    }
+};
+
+//  Returns the elapsed time in microseconds.
+template <typename Run> static long measure(Run run)
+{
+    auto watch = std::chrono::system_clock::now();
+    run();
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::system_clock::now() - watch).count();
+}
+
+static void report(std::string const& name, int message_size, int message_count, long elapsed)
+{
+    unsigned long throughput =
+        static_cast<double>(message_count) / static_cast<double>(elapsed) * 1000000;
+    double megabits = static_cast<double>(throughput * message_size * 8) / 1000000;
+
+    std::cout << name << " mean throughput: " << throughput << " [msg/s]\n";
+    std::cout << name << " mean throughput: " << megabits << " [Mb/s]\n";
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        std::cerr << "usage: inproc_thr_coro <message-size> <message-count>\n";
+        return 1;
+    }
+
+    int message_size = std::atoi(argv[1]);
+    int message_count = std::atoi(argv[2]);
+
+    std::cout << "message size: " << message_size << " [B]\n";
+    std::cout << "message count: " << message_count << "\n";
+
+    boost::asio::zmq::context ctx;
+
+    //  Same push/pull pair on one io_service, driven by callbacks and then
+    //  by coroutines.
+    long callbacks = measure([&] {
+        boost::asio::io_service ios;
+        boost::asio::zmq::test::perf::puller pl(ios, ctx, message_count, "inproc://thr_cb");
+        boost::asio::zmq::test::perf::pusher ps(ios, ctx, message_count, message_size,
+                                                "inproc://thr_cb");
+        ios.run();
+    });
+
+    long coroutines = measure([&] {
+        boost::asio::io_service ios;
+        boost::asio::zmq::socket puller(ios, ctx, ZMQ_PULL);
+        boost::asio::zmq::socket pusher(ios, ctx, ZMQ_PUSH);
+        puller.bind("inproc://thr_coro");
+        pusher.connect("inproc://thr_coro");
+        boost::asio::co_spawn(ios, pull(puller, message_count), boost::asio::detached);
+        boost::asio::co_spawn(ios, push(pusher, message_count, message_size),
+                              boost::asio::detached);
+        ios.run();
+    });
+
+    //  Each message takes one write and one read.
+    long posted = measure([&] {
+        boost::asio::io_service ios;
+        boost::asio::post(ios, reposter{&ios, message_count});
+        boost::asio::post(ios, reposter{&ios, message_count});
+        ios.run();
+    });
+
+    long awaited = measure([&] {
+        boost::asio::io_service ios;
+        boost::asio::co_spawn(ios, repost(message_count), boost::asio::detached);
+        boost::asio::co_spawn(ios, repost(message_count), boost::asio::detached);
+        ios.run();
+    });
+
+    report("callback", message_size, message_count, callbacks);
+    report("coroutine", message_size, message_count, coroutines);
+
+    //  The part of the coroutines' extra time per message that Asio spends on
+    //  the two awaits anyway, and what remains for the socket.
+    double asio = 1000.0 * (awaited - posted) / message_count;
+    double socket = 1000.0 * (coroutines - callbacks) / message_count - asio;
+    std::cout << "coroutine overhead in asio: " << asio << " [ns/msg]\n";
+    std::cout << "coroutine overhead in socket: " << socket << " [ns/msg]\n";
+}
+
+#else
+
+int main()
+{
+    std::cerr << "inproc_thr_coro: this build has no C++20 coroutine support\n";
+    return 1;
+}
+
+#endif
@@ -0,0 +1,132 @@
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/asio.hpp>
+#include <asio-zmq.hpp>
+#include "helper.hpp"
+
+//  Cost of per-operation deadlines. The first part measures push/pull
+//  throughput with and without a deadline on every read; the deadlines are
+//  never reached, so the difference is what scheduling and cancelling them
+//  costs. The second part leaves many reads with deadlines pending on a quiet
+//  socket and reports how long starting them took and how late they timed out.
+
+namespace perf = boost::asio::zmq::test::perf;
+
+typedef std::chrono::steady_clock clock_type;
+
+
+namespace {
+
+class deadline_puller {
+private:
+    boost::asio::zmq::socket puller_;
+    boost::asio::zmq::frame frame_;
+    int count_;
+    clock_type::duration timeout_;
+
+    void read()
+    {
+        puller_.async_read_frame(
+            frame_, clock_type::now() + timeout_,
+            std::bind(&deadline_puller::handle_read, this, std::placeholders::_1));
+    }
+
+    void handle_read(boost::system::error_code const& ec)
+    {
+        if (!ec && --count_ > 0) read();
+    }
+
+public:
+    deadline_puller(boost::asio::io_service& ios, boost::asio::zmq::context& ctx, int count,
+                    std::string const& ep, clock_type::duration timeout)
+        : puller_(ios, ctx, ZMQ_PULL), frame_(), count_(count), timeout_(timeout)
+    {
+        puller_.bind(ep);
+        read();
+    }
+};
+
+}  // namespace
+
+static unsigned long run_throughput(boost::asio::zmq::context& ctx, int message_size,
+                                    int message_count, bool deadlines,
+                                    clock_type::duration timeout)
+{
+    std::string ep = perf::make_endpoint("inproc", 0);
+    boost::asio::io_service ios;
+    std::unique_ptr<perf::puller> pl;
+    std::unique_ptr<deadline_puller> dpl;
+    if (deadlines)
+        dpl.reset(new deadline_puller(ios, ctx, message_count, ep, timeout));
+    else
+        pl.reset(new perf::puller(ios, ctx, message_count, ep));
+    perf::pusher ps(ios, ctx, message_count, message_size, ep);
+
+    auto watch = clock_type::now();
+    ios.run();
+    auto elapsed =
+        std::chrono::duration_cast<std::chrono::microseconds>(clock_type::now() - watch).count();
+    return static_cast<double>(message_count) / static_cast<double>(elapsed) * 1000000;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 5) {
+        std::cerr << "usage: inproc_thr_deadline <message-size> <message-count> <idle-reads> "
+                     "<timeout-ms>\n";
+        return 1;
+    }
+
+    int message_size = std::atoi(argv[1]);
+    int message_count = std::atoi(argv[2]);
+    int idle_reads = std::atoi(argv[3]);
+    clock_type::duration timeout = std::chrono::milliseconds(std::atoi(argv[4]));
+
+    std::cout << "message size: " << message_size << " [B]\n";
+    std::cout << "message count: " << message_count << "\n";
+    std::cout << "idle reads: " << idle_reads << "\n";
+
+    boost::asio::zmq::context ctx;
+
+    unsigned long plain = run_throughput(ctx, message_size, message_count, false, timeout);
+    unsigned long timed = run_throughput(ctx, message_size, message_count, true, timeout);
+
+    std::cout << "mean throughput without deadlines: " << plain << " [msg/s]\n";
+    std::cout << "mean throughput with deadlines: " << timed << " [msg/s]\n";
+
+    //  Every pending read takes the first message that arrives, so all of them
+    //  share one frame that nothing is ever written to.
+    boost::asio::io_service ios;
+    boost::asio::zmq::socket quiet(ios, ctx, ZMQ_PULL);
+    quiet.bind(perf::make_endpoint("inproc", 0));
+    boost::asio::zmq::frame frm;
+    boost::asio::zmq::histogram lateness;
+    int timeouts = 0;
+
+    auto watch = clock_type::now();
+    auto deadline = watch + timeout;
+    for (int i = 0; i < idle_reads; ++i) {
+        quiet.async_read_frame(frm, deadline, [&](boost::system::error_code const& ec, bool) {
+            if (ec != boost::asio::error::timed_out) return;
+            ++timeouts;
+            lateness.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                clock_type::now() - deadline).count());
+        });
+    }
+    auto started =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - watch).count();
+
+    ios.run();
+
+    std::cout << "start per read with deadline: "
+              << (idle_reads > 0 ? static_cast<double>(started) / idle_reads : 0.0) << " [ns]\n";
+    std::cout << "timed out: " << timeouts << "\n";
+    std::cout << "lateness p50: " << lateness.value_at(50) / 1000.0 << " [us]\n";
+    std::cout << "lateness p99: " << lateness.value_at(99) / 1000.0 << " [us]\n";
+    std::cout << "lateness max: " << lateness.max() / 1000.0 << " [us]\n";
+}
@@ -0,0 +1,45 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <boost/asio.hpp>
+#include <asio-zmq.hpp>
+#include "helper.hpp"
+
+static std::string const ep = "inproc://thr_pipe_test";
+
+int main(int argc, char* argv[])
+{
+    if (argc != 4) {
+        std::cerr << "usage: inproc_thr_pipe <message-size> <message-count> <window>\n";
+        return 1;
+    }
+
+    int message_size = std::atoi(argv[1]);
+    int message_count = std::atoi(argv[2]);
+    int window = std::atoi(argv[3]);
+
+    std::cout << "message size: " << message_size << " [B]\n";
+    std::cout << "message count: " << message_count << "\n";
+    std::cout << "window: " << window << "\n";
+
+    boost::asio::io_service ios;
+    boost::asio::zmq::context ctx;
+
+    boost::asio::zmq::test::perf::frame_puller pl(ios, ctx, message_count, ep);
+    boost::asio::zmq::test::perf::pipelined_pusher ps(ios, ctx, message_count, message_size,
+                                                        window, ep);
+
+    auto watch = std::chrono::system_clock::now();
+
+    ios.run();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::system_clock::now() - watch).count();
+    unsigned long throughput =
+        static_cast<double>(message_count) / static_cast<double>(elapsed) * 1000000;
+    double megabits = static_cast<double>(throughput * message_size * 8) / 1000000;
+
+    std::cout << "mean throughput: " << throughput << " [msg/s]\n";
+    std::cout << "mean throughput: " << megabits << " [Mb/s]\n";
+}
@@ -0,0 +1,61 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <boost/asio.hpp>
+#include <asio-zmq.hpp>
+#include "helper.hpp"
+
+static std::string const ep = "inproc://thr_pool_test";
+
+int main(int argc, char* argv[])
+{
+    if (argc != 4 || (std::strcmp(argv[3], "heap") != 0 && std::strcmp(argv[3], "pool") != 0 &&
+                      std::strcmp(argv[3], "hugepages") != 0)) {
+        std::cerr << "usage: inproc_thr_pool <message-size> <message-count> "
+                  << "<heap|pool|hugepages>\n";
+        return 1;
+    }
+
+    int message_size = std::atoi(argv[1]);
+    int message_count = std::atoi(argv[2]);
+    std::string mode = argv[3];
+
+    std::cout << "message size: " << message_size << " [B]\n";
+    std::cout << "message count: " << message_count << "\n";
+    std::cout << "payload allocation: " << mode << "\n";
+
+    boost::asio::io_service ios;
+    boost::asio::zmq::context ctx;
+
+    std::unique_ptr<boost::asio::zmq::frame_pool> pool;
+    if (mode != "heap")
+        pool.reset(new boost::asio::zmq::frame_pool(std::size_t(4) << 20, mode == "hugepages"));
+
+    boost::asio::zmq::test::perf::puller pl(ios, ctx, message_count, ep);
+    boost::asio::zmq::test::perf::pusher ps(ios, ctx, message_count, message_size, ep,
+                                            pool.get());
+
+    auto watch = std::chrono::system_clock::now();
+
+    ios.run();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::system_clock::now() - watch).count();
+    unsigned long throughput =
+        static_cast<double>(message_count) / static_cast<double>(elapsed) * 1000000;
+    double megabits = static_cast<double>(throughput * message_size * 8) / 1000000;
+
+    std::cout << "mean throughput: " << throughput << " [msg/s]\n";
+    std::cout << "mean throughput: " << megabits << " [Mb/s]\n";
+
+    if (pool) {
+        auto stats = pool->stats();
+        std::cout << "pool hits: " << stats.hits << "\n";
+        std::cout << "pool misses: " << stats.misses << "\n";
+        std::cout << "pool oversize: " << stats.oversize << "\n";
+        std::cout << "pool releases: " << stats.releases << "\n";
+    }
+}
@@ -0,0 +1,55 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/asio.hpp>
+#include <asio-zmq.hpp>
+#include "helper.hpp"
+
+//  Independent push/pull pipelines spread over the shards of a runtime.
+//  Both ends of pipeline i run on shard i modulo the number of shards.
+int main(int argc, char* argv[])
+{
+    if (argc != 4 && argc != 5) {
+        std::cerr << "usage: inproc_thr_sharded <message-size> <message-count> <pipelines> "
+                     "[shards]\n";
+        return 1;
+    }
+
+    int message_size = std::atoi(argv[1]);
+    int message_count = std::atoi(argv[2]);
+    int pipeline_count = std::atoi(argv[3]);
+    int shard_count = argc == 5 ? std::atoi(argv[4]) : 0;
+
+    boost::asio::zmq::runtime rt(shard_count);
+
+    std::cout << "message size: " << message_size << " [B]\n";
+    std::cout << "message count: " << message_count << " per pipeline\n";
+    std::cout << "pipelines: " << pipeline_count << "\n";
+    std::cout << "shards: " << rt.size() << "\n";
+
+    std::vector<std::unique_ptr<boost::asio::zmq::test::perf::puller>> pullers;
+    std::vector<std::unique_ptr<boost::asio::zmq::test::perf::pusher>> pushers;
+    for (int i = 0; i < pipeline_count; ++i) {
+        std::string ep = "inproc://thr_sharded_" + std::to_string(i);
+        pullers.emplace_back(new boost::asio::zmq::test::perf::puller(
+            rt.shard(i), rt.get_context(), message_count, ep));
+        pushers.emplace_back(new boost::asio::zmq::test::perf::pusher(
+            rt.shard(i), rt.get_context(), message_count, message_size, ep));
+    }
+
+    auto watch = std::chrono::system_clock::now();
+
+    rt.run();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::system_clock::now() - watch).count();
+    double total = static_cast<double>(message_count) * pipeline_count;
+    unsigned long throughput = total / static_cast<double>(elapsed) * 1000000;
+    double megabits = static_cast<double>(throughput * message_size * 8) / 1000000;
+
+    std::cout << "mean throughput: " << throughput << " [msg/s]\n";
+    std::cout << "mean throughput: " << megabits << " [Mb/s]\n";
+}
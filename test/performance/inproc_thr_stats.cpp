@@ -0,0 +1,89 @@
+#define ASIO_ZMQ_ENABLE_STATS
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <boost/asio.hpp>
+#include <asio-zmq.hpp>
+
+//  The push/pull throughput test with socket instrumentation compiled in,
+//  printing what each end saw.
+
+static void print_histogram(std::string const& name, boost::asio::zmq::histogram const& h)
+{
+    std::cout << "  " << name << " [ns]: count " << h.count() << ", p50 " << h.value_at(50)
+              << ", p99 " << h.value_at(99) << ", p99.9 " << h.value_at(99.9) << ", max "
+              << h.max() << "\n";
+}
+
+static void print_stats(std::string const& name, boost::asio::zmq::socket const& s)
+{
+    boost::asio::zmq::socket_stats st = s.stats();
+    std::cout << name << ":\n";
+    std::cout << "  messages sent/received: " << st.messages_sent << "/" << st.messages_received
+              << "\n";
+    std::cout << "  frames sent/received: " << st.frames_sent << "/" << st.frames_received
+              << "\n";
+    std::cout << "  bytes sent/received: " << st.bytes_sent << "/" << st.bytes_received << "\n";
+    std::cout << "  would block: " << st.would_block << "\n";
+    std::cout << "  wakeups: " << st.wakeups << " (spurious " << st.spurious_wakeups << ")\n";
+    print_histogram("queue delay", st.queue_delay);
+    print_histogram("ready to handler", st.ready_to_handler);
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        std::cerr << "usage: inproc_thr_stats <message-size> <message-count>\n";
+        return 1;
+    }
+
+    int message_size = std::atoi(argv[1]);
+    int message_count = std::atoi(argv[2]);
+
+    std::cout << "message size: " << message_size << " [B]\n";
+    std::cout << "message count: " << message_count << "\n";
+
+    boost::asio::io_service ios;
+    boost::asio::zmq::context ctx;
+    boost::asio::zmq::socket puller(ios, ctx, ZMQ_PULL);
+    boost::asio::zmq::socket pusher(ios, ctx, ZMQ_PUSH);
+    puller.bind("inproc://thr_stats");
+    pusher.connect("inproc://thr_stats");
+
+    boost::asio::zmq::message in;
+    int received = 0;
+    std::function<void(boost::system::error_code const&)> handle_read =
+        [&](boost::system::error_code const& ec) {
+            if (ec || ++received == message_count) return;
+            puller.async_read_message(in, handle_read);
+        };
+
+    boost::asio::zmq::message out;
+    int sent = 0;
+    std::function<void(boost::system::error_code const&)> handle_write =
+        [&](boost::system::error_code const& ec) {
+            if (ec || ++sent == message_count) return;
+            out.clear();
+            out.push_back(boost::asio::zmq::frame(message_size));
+            pusher.async_write_message(out, handle_write);
+        };
+
+    auto watch = std::chrono::system_clock::now();
+
+    puller.async_read_message(in, handle_read);
+    out.push_back(boost::asio::zmq::frame(message_size));
+    pusher.async_write_message(out, handle_write);
+    ios.run();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::system_clock::now() - watch).count();
+    unsigned long throughput =
+        static_cast<double>(message_count) / static_cast<double>(elapsed) * 1000000;
+
+    std::cout << "mean throughput: " << throughput << " [msg/s]\n";
+    print_stats("pusher", pusher);
+    print_stats("puller", puller);
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <asio-zmq/histogram.hpp>
+
+namespace boost {
+namespace asio {
+namespace zmq {
+namespace test {
+namespace perf {
+
+//  How a latency test reports: lines for people, or a single JSON object or
+//  CSV header and row for scripts.
+enum class report_format { text, json, csv };
+
+//  Takes an optional trailing text|json|csv argument off the command line.
+inline report_format take_report_format(int& argc, char* argv[])
+{
+    if (argc > 1) {
+        char const* last = argv[argc - 1];
+        if (std::strcmp(last, "text") == 0) {
+            --argc;
+            return report_format::text;
+        }
+        if (std::strcmp(last, "json") == 0) {
+            --argc;
+            return report_format::json;
+        }
+        if (std::strcmp(last, "csv") == 0) {
+            --argc;
+            return report_format::csv;
+        }
+    }
+    return report_format::text;
+}
+
+//  Times each roundtrip and records half of it, the one-way latency the tests
+//  have always averaged, in nanoseconds.
+class latency_recorder {
+private:
+    typedef std::chrono::steady_clock clock;
+
+    histogram histogram_;
+    clock::time_point start_;
+
+public:
+    latency_recorder() : histogram_(), start_() {}
+
+    void start() { start_ = clock::now(); }
+
+    void stop()
+    {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start_);
+        histogram_.record(static_cast<std::uint64_t>(elapsed.count()) / 2);
+    }
+
+    histogram const& results() const { return histogram_; }
+};
+
+static double const report_percentiles[] = {50, 90, 99, 99.9};
+static char const* const report_names[] = {"p50", "p90", "p99", "p99.9"};
+static char const* const report_keys[] = {"p50", "p90", "p99", "p99_9"};
+
+//  Writes ,"average_us":...,"p50_us":...,"max_us":... for a JSON object.
+inline void write_latency_fields(std::ostream& os, double average_us, histogram const& h)
+{
+    os << ",\"average_us\":" << average_us;
+    for (int i = 0; i < 4; ++i)
+        os << ",\"" << report_keys[i] << "_us\":" << h.value_at(report_percentiles[i]) / 1000.0;
+    os << ",\"max_us\":" << h.max() / 1000.0;
+}
+
+inline void report_latency(report_format format, char const* test, int message_size,
+                           int roundtrip_count, double average_us, histogram const& h)
+{
+    std::ostream& os = std::cout;
+    switch (format) {
+    case report_format::text:
+        os << "average latency: " << average_us << " [us]\n";
+        for (int i = 0; i < 4; ++i)
+            os << report_names[i] << " latency: " << h.value_at(report_percentiles[i]) / 1000.0
+               << " [us]\n";
+        os << "max latency: " << h.max() / 1000.0 << " [us]\n";
+        break;
+
+    case report_format::json:
+        os << "{\"test\":\"" << test << "\",\"message_size\":" << message_size
+           << ",\"roundtrip_count\":" << roundtrip_count;
+        write_latency_fields(os, average_us, h);
+        os << "}\n";
+        break;
+
+    case report_format::csv:
+        os << "test,message_size,roundtrip_count,average_us";
+        for (int i = 0; i < 4; ++i) os << "," << report_keys[i] << "_us";
+        os << ",max_us\n";
+        os << test << "," << message_size << "," << roundtrip_count << "," << average_us;
+        for (int i = 0; i < 4; ++i) os << "," << h.value_at(report_percentiles[i]) / 1000.0;
+        os << "," << h.max() / 1000.0 << "\n";
+        break;
+    }
+}
+
+}  // namespace perf
+}  // namespace test
+}  // namespace zmq
+}  // namespace asio
+}  // namespace boost
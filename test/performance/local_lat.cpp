@@ -7,18 +7,28 @@
 
 int main(int argc, char* argv[])
 {
-    if (argc != 4) {
+    if (argc != 4 && argc != 5) {
         std::cerr << "usage: local_lat <bind-to> <message-size> "
-                  << "<roundtrip-count>\n";
+                  << "<roundtrip-count> [io-thread-cpu]\n";
         return 1;
     }
 
+    //  The replier echoes whatever arrives, so the message size is not needed.
     std::string const ep = argv[1];
-    int message_size = std::atoi(argv[2]);
     int roundtrip_count = std::atoi(argv[3]);
 
     boost::asio::io_service ios;
     boost::asio::zmq::context ctx;
+
+    //  Pins ZeroMQ's I/O thread to the given cpu, away from the io_service.
+    if (argc == 5) {
+#ifdef ZMQ_THREAD_AFFINITY_CPU_ADD
+        ctx.add_thread_affinity_cpu(std::atoi(argv[4]));
+#else
+        std::cerr << "io-thread-cpu: not supported by this libzmq\n";
+        return 1;
+#endif
+    }
     boost::asio::zmq::test::perf::replier replier(ios, ctx, roundtrip_count, ep);
 
     ios.run();
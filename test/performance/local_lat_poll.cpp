@@ -7,7 +7,6 @@ int main(int argc, char* argv[])
 {
     const char* bind_to;
     int roundtrip_count;
-    size_t message_size;
     void* ctx;
     void* s;
     int rc;
@@ -18,8 +17,8 @@ int main(int argc, char* argv[])
                "<roundtrip-count>\n");
         return 1;
     }
+    //  Replies echo the requests, so the message size is not needed.
     bind_to = argv[1];
-    message_size = atoi(argv[2]);
     roundtrip_count = atoi(argv[3]);
 
     ctx = zmq_init(1);
@@ -0,0 +1,311 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <asio-zmq.hpp>
+#include "helper.hpp"
+
+//  Open-loop latency: a pusher sends at a fixed rate whether or not earlier
+//  messages have been received, and a puller on another thread measures how
+//  long each one took. Every message carries the time it was meant to be sent
+//  and the time it actually was. Latency counted from the intended time is
+//  corrected for coordinated omission: when the sender falls behind, the
+//  messages it should have sent in the meantime are charged the wait rather
+//  than silently left out. The uncorrected figures, counted from the actual
+//  send, are printed alongside to show the difference.
+//
+//  Each rate runs for the given duration on fresh sockets. The sweep stops
+//  after the first rate the pair could not sustain, the knee of the curve;
+//  beyond it latency only measures the growing queue.
+
+namespace perf = boost::asio::zmq::test::perf;
+
+typedef std::chrono::steady_clock clock_type;
+
+static std::int64_t nanoseconds(clock_type::time_point t)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+namespace {
+
+class paced_pusher {
+private:
+    boost::asio::zmq::socket pusher_;
+    boost::asio::steady_timer timer_;
+    //  Writes complete in the order they were started, so the message of the
+    //  oldest outstanding write is always at the front.
+    std::deque<boost::asio::zmq::message> pending_;
+    int size_;
+    long total_;
+    long sent_;
+    double interval_ns_;
+    clock_type::time_point start_;
+    clock_type::time_point last_send_;
+
+    clock_type::time_point intended(long n) const
+    {
+        return start_ + std::chrono::nanoseconds(static_cast<std::int64_t>(n * interval_ns_));
+    }
+
+    void send(clock_type::time_point when, clock_type::time_point now)
+    {
+        boost::asio::zmq::frame frm(size_);
+        std::int64_t stamps[2] = {nanoseconds(when), nanoseconds(now)};
+        std::memcpy(frm.data(), stamps, sizeof(stamps));
+
+        pending_.emplace_back();
+        pending_.back().push_back(std::move(frm));
+        pusher_.async_write_message(pending_.back(),
+                                    [this](boost::system::error_code const&) {
+                                        pending_.pop_front();
+                                    });
+    }
+
+    void schedule()
+    {
+        timer_.expires_at(intended(sent_));
+        timer_.async_wait(std::bind(&paced_pusher::handle_timer, this, std::placeholders::_1));
+    }
+
+    //  Sends every message that is due, so that a late wakeup turns into a
+    //  burst rather than a lower rate.
+    void handle_timer(boost::system::error_code const& ec)
+    {
+        if (ec) return;
+
+        clock_type::time_point now = clock_type::now();
+        while (sent_ < total_ && intended(sent_) <= now) {
+            send(intended(sent_), now);
+            ++sent_;
+        }
+        last_send_ = now;
+        if (sent_ < total_) schedule();
+    }
+
+public:
+    paced_pusher(boost::asio::io_service& ios, boost::asio::zmq::context& ctx,
+                 std::string const& ep, int size, long total, double rate)
+        : pusher_(ios, ctx, ZMQ_PUSH),
+          timer_(ios),
+          pending_(),
+          size_(size),
+          total_(total),
+          sent_(0),
+          interval_ns_(1e9 / rate),
+          start_(),
+          last_send_()
+    {
+        pusher_.connect(ep);
+    }
+
+    void start(clock_type::time_point start)
+    {
+        start_ = start;
+        schedule();
+    }
+
+    clock_type::time_point last_send() const { return last_send_; }
+};
+
+class stamp_puller {
+private:
+    boost::asio::zmq::socket puller_;
+    boost::asio::zmq::message msg_;
+    long remaining_;
+    boost::asio::zmq::histogram corrected_;
+    boost::asio::zmq::histogram uncorrected_;
+    clock_type::time_point last_receive_;
+
+    void read()
+    {
+        puller_.async_read_message(
+            msg_, std::bind(&stamp_puller::handle_read, this, std::placeholders::_1));
+    }
+
+    void handle_read(boost::system::error_code const& ec)
+    {
+        if (ec) return;
+
+        last_receive_ = clock_type::now();
+        std::int64_t now = nanoseconds(last_receive_);
+        std::int64_t stamps[2];
+        std::memcpy(stamps, msg_[0].data(), sizeof(stamps));
+        corrected_.record(static_cast<std::uint64_t>(now - stamps[0]));
+        uncorrected_.record(static_cast<std::uint64_t>(now - stamps[1]));
+
+        if (--remaining_ > 0) read();
+    }
+
+public:
+    stamp_puller(boost::asio::io_service& ios, boost::asio::zmq::context& ctx,
+                 std::string const& ep, long total)
+        : puller_(ios, ctx, ZMQ_PULL),
+          msg_(),
+          remaining_(total),
+          corrected_(),
+          uncorrected_(),
+          last_receive_()
+    {
+        puller_.bind(ep);
+        read();
+    }
+
+    boost::asio::zmq::histogram const& corrected() const { return corrected_; }
+
+    boost::asio::zmq::histogram const& uncorrected() const { return uncorrected_; }
+
+    clock_type::time_point last_receive() const { return last_receive_; }
+};
+
+struct point {
+    double target_rate;
+    double send_rate;
+    double receive_rate;
+    boost::asio::zmq::histogram corrected;
+    boost::asio::zmq::histogram uncorrected;
+};
+
+}  // namespace
+
+static point run(boost::asio::zmq::context& ctx, std::string const& transport, int message_size,
+                 int duration_ms, double rate)
+{
+    long total = static_cast<long>(rate * duration_ms / 1000);
+    if (total < 1) total = 1;
+    std::string ep = perf::make_endpoint(transport, 5800);
+
+    boost::asio::io_service send_ios;
+    boost::asio::io_service receive_ios;
+    stamp_puller puller(receive_ios, ctx, ep, total);
+    paced_pusher pusher(send_ios, ctx, ep, message_size, total, rate);
+
+    //  Leaves time for a tcp or ipc connection to be established.
+    auto start = clock_type::now() + std::chrono::milliseconds(100);
+    pusher.start(start);
+
+    std::thread receiver([&receive_ios] { receive_ios.run(); });
+    send_ios.run();
+    receiver.join();
+
+    auto seconds = [start](clock_type::time_point end) {
+        return std::chrono::duration<double>(end - start).count();
+    };
+    //  The n-th message is due at n / rate seconds, so a pair that keeps up
+    //  finishes one interval short of total / rate.
+    point p;
+    p.target_rate = rate;
+    p.send_rate = total / (seconds(pusher.last_send()) + 1 / rate);
+    p.receive_rate = total / (seconds(puller.last_receive()) + 1 / rate);
+    p.corrected = puller.corrected();
+    p.uncorrected = puller.uncorrected();
+    return p;
+}
+
+static void report(perf::report_format format, std::string const& transport, int message_size,
+                   std::vector<point> const& points)
+{
+    switch (format) {
+    case perf::report_format::text:
+        std::cout << "target [msg/s]  sent [msg/s]  received [msg/s]  "
+                     "p50  p90  p99  p99.9  max [us, corrected]  p50  p99  max [us, uncorrected]\n";
+        for (auto const& p : points) {
+            std::cout << static_cast<unsigned long>(p.target_rate) << "  "
+                      << static_cast<unsigned long>(p.send_rate) << "  "
+                      << static_cast<unsigned long>(p.receive_rate);
+            for (double q : perf::report_percentiles)
+                std::cout << "  " << p.corrected.value_at(q) / 1000.0;
+            std::cout << "  " << p.corrected.max() / 1000.0;
+            std::cout << "  " << p.uncorrected.value_at(50) / 1000.0 << "  "
+                      << p.uncorrected.value_at(99) / 1000.0 << "  "
+                      << p.uncorrected.max() / 1000.0 << "\n";
+        }
+        break;
+
+    case perf::report_format::json:
+        std::cout << "[";
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            point const& p = points[i];
+            std::cout << (i == 0 ? "\n  " : ",\n  ") << "{\"transport\":\"" << transport
+                      << "\",\"message_size\":" << message_size
+                      << ",\"target_rate\":" << static_cast<unsigned long>(p.target_rate)
+                      << ",\"send_rate\":" << static_cast<unsigned long>(p.send_rate)
+                      << ",\"receive_rate\":" << static_cast<unsigned long>(p.receive_rate);
+            for (int k = 0; k < 4; ++k)
+                std::cout << ",\"" << perf::report_keys[k]
+                          << "_us\":" << p.corrected.value_at(perf::report_percentiles[k]) / 1000.0;
+            std::cout << ",\"max_us\":" << p.corrected.max() / 1000.0
+                      << ",\"uncorrected_p50_us\":" << p.uncorrected.value_at(50) / 1000.0
+                      << ",\"uncorrected_p99_us\":" << p.uncorrected.value_at(99) / 1000.0
+                      << ",\"uncorrected_max_us\":" << p.uncorrected.max() / 1000.0 << "}";
+        }
+        std::cout << "\n]\n";
+        break;
+
+    case perf::report_format::csv:
+        std::cout << "transport,message_size,target_rate,send_rate,receive_rate";
+        for (int k = 0; k < 4; ++k) std::cout << "," << perf::report_keys[k] << "_us";
+        std::cout << ",max_us,uncorrected_p50_us,uncorrected_p99_us,uncorrected_max_us\n";
+        for (auto const& p : points) {
+            std::cout << transport << "," << message_size << ","
+                      << static_cast<unsigned long>(p.target_rate) << ","
+                      << static_cast<unsigned long>(p.send_rate) << ","
+                      << static_cast<unsigned long>(p.receive_rate);
+            for (double q : perf::report_percentiles)
+                std::cout << "," << p.corrected.value_at(q) / 1000.0;
+            std::cout << "," << p.corrected.max() / 1000.0 << ","
+                      << p.uncorrected.value_at(50) / 1000.0 << ","
+                      << p.uncorrected.value_at(99) / 1000.0 << ","
+                      << p.uncorrected.max() / 1000.0 << "\n";
+        }
+        break;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    auto format = perf::take_report_format(argc, argv);
+    if (argc != 5) {
+        std::cerr << "usage: openloop_lat <inproc|ipc|tcp> <message-size> <duration-ms> "
+                     "<rate>[,<rate>...] [text|json|csv]\n";
+        return 1;
+    }
+
+    std::string transport = argv[1];
+    int message_size = std::atoi(argv[2]);
+    int duration_ms = std::atoi(argv[3]);
+
+    std::vector<double> rates;
+    std::istringstream is(argv[4]);
+    std::string rate;
+    while (std::getline(is, rate, ',')) rates.push_back(std::atof(rate.c_str()));
+
+    bool valid = transport == "inproc" || transport == "ipc" || transport == "tcp";
+    for (double r : rates) valid = valid && r > 0;
+    if (!valid || rates.empty() || duration_ms <= 0) {
+        std::cerr << "openloop_lat: invalid argument\n";
+        return 1;
+    }
+
+    //  The two timestamps travel in the payload.
+    int const min_size = 2 * sizeof(std::int64_t);
+    if (message_size < min_size) message_size = min_size;
+
+    boost::asio::zmq::context ctx;
+    std::vector<point> points;
+    for (double r : rates) {
+        points.push_back(run(ctx, transport, message_size, duration_ms, r));
+        if (points.back().receive_rate < 0.9 * r) break;
+    }
+
+    report(format, transport, message_size, points);
+}
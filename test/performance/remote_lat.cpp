@@ -8,9 +8,10 @@
 
 int main(int argc, char* argv[])
 {
-    if (argc != 4) {
-        std::cerr << "usage: local_lat <bind-to> <message-size> "
-                  << "<roundtrip-count>\n";
+    auto format = boost::asio::zmq::test::perf::take_report_format(argc, argv);
+    if (argc != 4 && argc != 5) {
+        std::cerr << "usage: remote_lat <connect-to> <message-size> "
+                  << "<roundtrip-count> [io-thread-cpu] [text|json|csv]\n";
         return 1;
     }
 
@@ -21,17 +22,33 @@ int main(int argc, char* argv[])
     boost::asio::io_service ios;
     boost::asio::zmq::context ctx;
 
-    boost::asio::zmq::test::perf::requester requester(ios, ctx, roundtrip_count, message_size, ep);
+    //  Pins ZeroMQ's I/O thread to the given cpu, away from the io_service.
+    if (argc == 5) {
+#ifdef ZMQ_THREAD_AFFINITY_CPU_ADD
+        ctx.add_thread_affinity_cpu(std::atoi(argv[4]));
+#else
+        std::cerr << "io-thread-cpu: not supported by this libzmq\n";
+        return 1;
+#endif
+    }
+
+    boost::asio::zmq::test::perf::latency_recorder latency;
+    boost::asio::zmq::test::perf::requester requester(ios, ctx, roundtrip_count, message_size, ep,
+                                                      boost::asio::zmq::completion_mode::post,
+                                                      &latency);
 
     auto watch = std::chrono::system_clock::now();
 
     ios.run();
 
     auto elapsed = std::chrono::system_clock::now() - watch;
-    double latency = static_cast<double>(
+    double average = static_cast<double>(
                          std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()) /
                      (roundtrip_count * 2);
-    std::cout << "message size: " << message_size << " [B]\n";
-    std::cout << "roundtrip count: " << roundtrip_count << "\n";
-    std::cout << "average latency: " << latency << " [us]\n";
-}
\ No newline at end of file
+    if (format == boost::asio::zmq::test::perf::report_format::text) {
+        std::cout << "message size: " << message_size << " [B]\n";
+        std::cout << "roundtrip count: " << roundtrip_count << "\n";
+    }
+    boost::asio::zmq::test::perf::report_latency(format, "remote_lat", message_size,
+                                                 roundtrip_count, average, latency.results());
+}
@@ -3,6 +3,7 @@
 #include <string.h>
 #include <zmq.h>
 #include <zmq_utils.h>
+#include "latency.hpp"
 
 int main(int argc, char* argv[])
 {
@@ -16,11 +17,14 @@ int main(int argc, char* argv[])
     zmq_msg_t msg;
     void* watch;
     unsigned long elapsed;
-    double latency;
+    double average;
+    boost::asio::zmq::test::perf::report_format format;
+    boost::asio::zmq::test::perf::latency_recorder latency;
 
+    format = boost::asio::zmq::test::perf::take_report_format(argc, argv);
     if (argc != 4) {
         printf("usage: remote_lat <connect-to> <message-size> "
-               "<roundtrip-count>\n");
+               "<roundtrip-count> [text|json|csv]\n");
         return 1;
     }
     connect_to = argv[1];
@@ -64,10 +68,12 @@ int main(int argc, char* argv[])
                 printf("error in zmq_msg_recv: %s\n", zmq_strerror(errno));
                 return -1;
             }
+            latency.stop();
             items[0].events = ZMQ_POLLOUT;
         }
         if ((items[0].revents & ZMQ_POLLOUT) == ZMQ_POLLOUT) {
             if (i++ == roundtrip_count) break;
+            latency.start();
             if (zmq_msg_send(&msg, s, 0) < 0) {
                 printf("error in zmq_msg_send: %s\n", zmq_strerror(errno));
                 return -1;
@@ -84,11 +90,14 @@ int main(int argc, char* argv[])
         return -1;
     }
 
-    latency = (double)elapsed / (roundtrip_count * 2);
+    average = (double)elapsed / (roundtrip_count * 2);
 
-    printf("message size: %d [B]\n", (int)message_size);
-    printf("roundtrip count: %d\n", (int)roundtrip_count);
-    printf("average latency: %.3f [us]\n", (double)latency);
+    if (format == boost::asio::zmq::test::perf::report_format::text) {
+        printf("message size: %d [B]\n", (int)message_size);
+        printf("roundtrip count: %d\n", (int)roundtrip_count);
+    }
+    boost::asio::zmq::test::perf::report_latency(format, "remote_lat_poll", (int)message_size,
+                                                 roundtrip_count, average, latency.results());
 
     rc = zmq_close(s);
     if (rc != 0) {
@@ -0,0 +1,181 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/asio.hpp>
+#include <asio-zmq.hpp>
+#include "helper.hpp"
+
+//  Aggregate push/pull throughput of many producers and consumers as the
+//  number of io_service threads and of ZeroMQ I/O threads grows. Every puller
+//  binds an endpoint of its own and every pusher connects to all of them, so
+//  each pusher spreads its messages over every puller. Sockets are placed
+//  round-robin on the shards of a runtime, one thread per shard; one shard
+//  runs everything on a single io_service.
+//
+//  Prints one CSV row per combination of threads and I/O threads, doubling
+//  each from 1 up to its maximum, ready to be plotted.
+
+namespace perf = boost::asio::zmq::test::perf;
+
+namespace {
+
+class fanout_pusher {
+private:
+    boost::asio::zmq::socket pusher_;
+    int count_;
+    int size_;
+
+    void write()
+    {
+        pusher_.async_write_frame(
+            boost::asio::zmq::frame(size_), 0,
+            std::bind(&fanout_pusher::handle_write, this, std::placeholders::_1));
+    }
+
+    void handle_write(boost::system::error_code const& ec)
+    {
+        if (!ec && --count_ > 0) write();
+    }
+
+public:
+    fanout_pusher(boost::asio::io_service& ios, boost::asio::zmq::context& ctx, int count,
+                  int size, std::vector<std::string> const& eps)
+        : pusher_(ios, ctx, ZMQ_PUSH), count_(count), size_(size)
+    {
+        for (auto const& ep : eps) pusher_.connect(ep);
+    }
+
+    void start() { write(); }
+};
+
+//  Counts into a total shared by all pullers; whichever receives the last
+//  message fulfils done.
+class counting_puller {
+private:
+    boost::asio::zmq::socket puller_;
+    boost::asio::zmq::frame frame_;
+    std::atomic<long>& received_;
+    long total_;
+    std::promise<void>& done_;
+
+    void read()
+    {
+        puller_.async_read_frame(frame_, std::bind(&counting_puller::handle_read, this,
+                                                   std::placeholders::_1, std::placeholders::_2));
+    }
+
+    void handle_read(boost::system::error_code const& ec, bool more)
+    {
+        if (ec) return;
+        long n = received_.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (n == total_) done_.set_value();
+        if (n < total_) read();
+    }
+
+public:
+    counting_puller(boost::asio::io_service& ios, boost::asio::zmq::context& ctx,
+                    std::string const& ep, std::atomic<long>& received, long total,
+                    std::promise<void>& done)
+        : puller_(ios, ctx, ZMQ_PULL), frame_(), received_(received), total_(total), done_(done)
+    {
+        puller_.bind(ep);
+    }
+
+    void start() { read(); }
+};
+
+}  // namespace
+
+static std::vector<int> doublings(int max)
+{
+    std::vector<int> values;
+    for (int v = 1; v < max; v *= 2) values.push_back(v);
+    values.push_back(max);
+    return values;
+}
+
+//  Returns the aggregate throughput in messages per second.
+static double run(std::string const& transport, int message_size, int message_count,
+                  int pusher_count, int puller_count, int threads, int io_threads)
+{
+    boost::asio::zmq::runtime rt(threads);
+    rt.get_context().set_io_threads(io_threads);
+
+    long total = static_cast<long>(message_count) * pusher_count;
+    std::atomic<long> received(0);
+    std::promise<void> done;
+
+    std::vector<std::string> eps;
+    for (int i = 0; i < puller_count; ++i) eps.push_back(perf::make_endpoint(transport, 5700));
+
+    std::vector<std::unique_ptr<counting_puller>> pullers;
+    std::vector<std::unique_ptr<fanout_pusher>> pushers;
+    for (int i = 0; i < puller_count; ++i)
+        pullers.emplace_back(
+            new counting_puller(rt.next_shard(), rt.get_context(), eps[i], received, total, done));
+    for (int i = 0; i < pusher_count; ++i)
+        pushers.emplace_back(new fanout_pusher(rt.next_shard(), rt.get_context(), message_count,
+                                               message_size, eps));
+
+    //  Operations are started before the shards run, so that no handler can
+    //  race with the construction of the sockets above.
+    for (auto& p : pullers) p->start();
+    for (auto& p : pushers) p->start();
+
+    auto watch = std::chrono::steady_clock::now();
+
+    rt.start();
+    done.get_future().wait();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - watch).count();
+
+    //  The pullers' last reads are still pending; abandon them.
+    rt.stop();
+    return static_cast<double>(total) / static_cast<double>(elapsed) * 1000000;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 8) {
+        std::cerr << "usage: scaling_thr <inproc|ipc|tcp> <message-size> <message-count> "
+                     "<pushers> <pullers> <max-threads> <max-io-threads>\n";
+        return 1;
+    }
+
+    std::string transport = argv[1];
+    int message_size = std::atoi(argv[2]);
+    int message_count = std::atoi(argv[3]);
+    int pusher_count = std::atoi(argv[4]);
+    int puller_count = std::atoi(argv[5]);
+    int max_threads = std::atoi(argv[6]);
+    int max_io_threads = std::atoi(argv[7]);
+
+    if ((transport != "inproc" && transport != "ipc" && transport != "tcp") || message_size < 0 ||
+        message_count <= 0 || pusher_count <= 0 || puller_count <= 0 || max_threads <= 0 ||
+        max_io_threads <= 0) {
+        std::cerr << "scaling_thr: invalid argument\n";
+        return 1;
+    }
+
+    //  message-count is per pusher.
+    std::cout << "transport,message_size,message_count,pushers,pullers,threads,io_threads,"
+                 "msg_s,mb_s\n";
+    for (int threads : doublings(max_threads)) {
+        for (int io_threads : doublings(max_io_threads)) {
+            double throughput = run(transport, message_size, message_count, pusher_count,
+                                    puller_count, threads, io_threads);
+            double megabits = throughput * message_size * 8 / 1000000;
+            std::cout << transport << "," << message_size << "," << message_count << ","
+                      << pusher_count << "," << puller_count << "," << threads << ","
+                      << io_threads << "," << static_cast<unsigned long>(throughput) << ","
+                      << megabits << std::endl;
+        }
+    }
+}
@@ -0,0 +1,189 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/version.hpp>
+#include <boost/asio.hpp>
+#include <asio-zmq.hpp>
+
+//  Reads with deadlines on an io_service run by several threads, their
+//  handlers bound to a strand per socket. The messages arrive around the
+//  deadlines, so expiries keep racing the reads they belong to: every read
+//  must complete exactly once, on its strand, and no message may be lost to
+//  a read that timed out. Build with -fsanitize=address or thread to catch an
+//  expiry touching a read that has finished.
+
+namespace zmq = boost::asio::zmq;
+
+typedef std::chrono::steady_clock clock_type;
+
+#if BOOST_VERSION >= 106600
+
+namespace {
+
+typedef boost::asio::strand<boost::asio::io_service::executor_type> strand_type;
+
+int failures = 0;
+
+void check(bool ok, char const* what)
+{
+    if (!ok) {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failures;
+    }
+}
+
+int const runner_count = 4;
+int const reader_count = 4;
+int const message_count = 1000;
+
+//  Reads message_count frames, each with a deadline of a millisecond, and
+//  reads again after every completion until all have arrived.
+class reader {
+private:
+    zmq::socket in_;
+    strand_type strand_;
+    zmq::frame frm_;
+
+    void start()
+    {
+        ++started_;
+        in_.async_read_frame(frm_, clock_type::now() + std::chrono::milliseconds(1),
+                             boost::asio::bind_executor(
+                                 strand_, [this](boost::system::error_code const& ec, bool) {
+                                     on_read(ec);
+                                 }));
+    }
+
+    void on_read(boost::system::error_code const& ec)
+    {
+        ++completed_;
+        if (!strand_.running_in_this_thread()) ++off_strand_;
+        if (!ec) {
+            std::string text(static_cast<char const*>(frm_.data()), frm_.size());
+            if (text != std::to_string(received_)) in_order_ = false;
+            ++received_;
+        }
+        else if (ec == boost::asio::error::timed_out) {
+            ++timeouts_;
+        }
+        else {
+            ++errors_;
+        }
+        if (received_ < message_count)
+            start();
+        else
+            done_ = true;
+    }
+
+public:
+    int started_;
+    int completed_;
+    int received_;
+    int timeouts_;
+    int errors_;
+    int off_strand_;
+    bool in_order_;
+    std::atomic<bool> done_;
+
+    reader(boost::asio::io_service& ios, zmq::context& ctx, std::string const& endpoint)
+        : in_(ios, ctx, ZMQ_PULL),
+          strand_(ios.get_executor()),
+          frm_(),
+          started_(0),
+          completed_(0),
+          received_(0),
+          timeouts_(0),
+          errors_(0),
+          off_strand_(0),
+          in_order_(true),
+          done_(false)
+    {
+        in_.bind(endpoint);
+    }
+
+    void run()
+    {
+        boost::asio::post(strand_, [this] { start(); });
+    }
+};
+
+//  Sends message_count frames with pauses of up to one and a half ticks, so
+//  that many arrive as their read's deadline passes.
+void write_all(zmq::context& ctx, std::string const& endpoint, unsigned seed)
+{
+    boost::asio::io_service ios;
+    zmq::socket out(ios, ctx, ZMQ_PUSH);
+    out.connect(endpoint);
+    std::minstd_rand rand(seed);
+    std::uniform_int_distribution<int> pause(0, 1500);
+    for (int i = 0; i < message_count; ++i) {
+        out.write_frame(zmq::frame(std::to_string(i)), 0);
+        std::this_thread::sleep_for(std::chrono::microseconds(pause(rand)));
+    }
+}
+
+}  // namespace
+
+int main()
+{
+    boost::asio::io_service ios;
+    zmq::context ctx;
+    std::vector<std::unique_ptr<reader>> readers;
+    for (int i = 0; i < reader_count; ++i) {
+        std::string endpoint = "inproc://strands." + std::to_string(i);
+        readers.emplace_back(new reader(ios, ctx, endpoint));
+        readers.back()->run();
+    }
+
+    std::unique_ptr<boost::asio::io_service::work> work(new boost::asio::io_service::work(ios));
+    std::vector<std::thread> runners;
+    for (int i = 0; i < runner_count; ++i) runners.emplace_back([&] { ios.run(); });
+
+    std::vector<std::thread> writers;
+    for (int i = 0; i < reader_count; ++i) {
+        writers.emplace_back([&ctx, i] {
+            write_all(ctx, "inproc://strands." + std::to_string(i), i + 1);
+        });
+    }
+    for (auto& t : writers) t.join();
+
+    clock_type::time_point give_up = clock_type::now() + std::chrono::seconds(10);
+    for (auto& r : readers) {
+        while (!r->done_ && clock_type::now() < give_up)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    work.reset();
+    ios.stop();
+    for (auto& t : runners) t.join();
+
+    int timeouts = 0;
+    for (auto& r : readers) {
+        check(r->done_, "every message is read");
+        check(r->received_ == message_count, "no message is lost to a read that timed out");
+        check(r->in_order_, "messages are read in order");
+        check(r->completed_ == r->started_, "every read completes exactly once");
+        check(r->errors_ == 0, "reads complete with success or timed_out");
+        check(r->off_strand_ == 0, "read handlers run on their strand");
+        timeouts += r->timeouts_;
+    }
+    check(timeouts > 0, "some reads time out");
+
+    if (failures != 0) return 1;
+    std::cout << "deadline_strands: ok" << std::endl;
+    return 0;
+}
+
+#else
+
+int main()
+{
+    std::cout << "deadline_strands: needs executors, skipped" << std::endl;
+    return 0;
+}
+
+#endif
@@ -0,0 +1,118 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include <asio-zmq.hpp>
+
+//  The deadline_service of an io_service is shared by every socket on it,
+//  which may be used from different threads while the io_service's threads
+//  run the timer. Several threads schedule and cancel deadlines at once; every
+//  deadline left scheduled must expire exactly once, and no cancelled one may.
+//  Build with -fsanitize=thread to catch unguarded access to the wheel.
+
+namespace zmq = boost::asio::zmq;
+
+typedef zmq::deadline_service::clock_type clock_type;
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, char const* what)
+{
+    if (!ok) {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failures;
+    }
+}
+
+class counted_deadline : public zmq::detail::deadline_entry {
+private:
+    //  There is no handler; the entry itself stands in for one without an executor.
+    static void do_submit(zmq::detail::deadline_entry* base,
+                          zmq::detail::deadline_expiry&& expiry)
+    {
+        std::move(expiry).submit(*base);
+    }
+
+    static void do_expire(zmq::detail::deadline_entry* base)
+    {
+        static_cast<counted_deadline*>(base)->expired_.fetch_add(1);
+    }
+
+public:
+    std::atomic<int> expired_;
+
+    counted_deadline()
+        : zmq::detail::deadline_entry(&counted_deadline::do_submit, &counted_deadline::do_expire),
+          expired_(0)
+    {
+    }
+};
+
+int const thread_count = 4;
+int const round_count = 20;
+int const deadline_count = 200;
+
+//  Every other deadline is far enough out to be cancelled before it passes.
+void schedule_and_cancel(zmq::deadline_service& service, std::atomic<int>& expired_twice,
+                         std::atomic<int>& cancelled_expired, std::atomic<int>& missed)
+{
+    for (int round = 0; round < round_count; ++round) {
+        std::unique_ptr<counted_deadline[]> deadlines(new counted_deadline[deadline_count]);
+        clock_type::time_point now = clock_type::now();
+        for (int i = 0; i < deadline_count; ++i) {
+            clock_type::time_point at = i % 2 == 0 ? now + std::chrono::milliseconds(1 + i % 4)
+                                                   : now + std::chrono::seconds(10);
+            service.schedule(deadlines[i], at);
+        }
+        for (int i = 1; i < deadline_count; i += 2) service.cancel(deadlines[i]);
+
+        clock_type::time_point give_up = clock_type::now() + std::chrono::seconds(5);
+        for (int i = 0; i < deadline_count; i += 2) {
+            while (deadlines[i].expired_ == 0 && clock_type::now() < give_up)
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        for (int i = 0; i < deadline_count; ++i) {
+            int n = deadlines[i].expired_;
+            if (i % 2 == 0 && n == 0) ++missed;
+            if (n > 1) ++expired_twice;
+            if (i % 2 == 1 && n != 0) ++cancelled_expired;
+            service.cancel(deadlines[i]);
+        }
+    }
+}
+
+}  // namespace
+
+int main()
+{
+    boost::asio::io_service ios;
+    zmq::deadline_service& service = boost::asio::use_service<zmq::deadline_service>(ios);
+    std::unique_ptr<boost::asio::io_service::work> work(new boost::asio::io_service::work(ios));
+    std::vector<std::thread> runners;
+    for (int i = 0; i < 2; ++i) runners.emplace_back([&] { ios.run(); });
+
+    std::atomic<int> expired_twice(0), cancelled_expired(0), missed(0);
+    std::vector<std::thread> users;
+    for (int i = 0; i < thread_count; ++i) {
+        users.emplace_back(
+            [&] { schedule_and_cancel(service, expired_twice, cancelled_expired, missed); });
+    }
+    for (auto& t : users) t.join();
+
+    check(service.pending() == 0, "no deadline is left pending");
+    work.reset();
+    for (auto& t : runners) t.join();
+
+    check(missed == 0, "every deadline left scheduled expires");
+    check(expired_twice == 0, "no deadline expires twice");
+    check(cancelled_expired == 0, "no cancelled deadline expires");
+
+    if (failures != 0) return 1;
+    std::cout << "deadline_threads: ok" << std::endl;
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <boost/version.hpp>
+#include <boost/asio.hpp>
+#include <asio-zmq.hpp>
+
+//  Handlers bound to an executor must run on it: on their strand, or on
+//  another io_service, which the socket must keep from running out of work
+//  while it holds the handler.
+
+namespace zmq = boost::asio::zmq;
+
+typedef std::chrono::steady_clock clock_type;
+
+#if BOOST_VERSION >= 106600
+
+namespace {
+
+typedef boost::asio::strand<boost::asio::io_service::executor_type> strand_type;
+
+int failures = 0;
+
+void check(bool ok, char const* what)
+{
+    if (!ok) {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failures;
+    }
+}
+
+//  Counts the completions that ran, and those that ran on the strand.
+struct tally {
+    int calls;
+    int on_strand;
+
+    tally() : calls(0), on_strand(0) {}
+
+    void operator()(strand_type const& strand)
+    {
+        ++calls;
+        if (strand.running_in_this_thread()) ++on_strand;
+    }
+
+    bool all_on_strand(int expected) const { return calls == expected && on_strand == calls; }
+};
+
+void strand_handlers(zmq::context& ctx, zmq::completion_mode mode, char const* endpoint)
+{
+    boost::asio::io_service ios;
+    strand_type strand(ios.get_executor());
+    zmq::socket in(ios, ctx, ZMQ_PULL);
+    zmq::socket out(ios, ctx, ZMQ_PUSH);
+    in.set_completion_mode(mode);
+    out.set_completion_mode(mode);
+    in.bind(endpoint);
+
+    //  The reads wait for the writes, which wait for the connect; the last read
+    //  has a deadline and times out.
+    tally reads, writes;
+    zmq::frame first, late;
+    zmq::message msg;
+    in.async_read_frame(first, boost::asio::bind_executor(
+                                   strand, [&](boost::system::error_code const&, bool) {
+                                       reads(strand);
+                                   }));
+    in.async_read_message(msg, clock_type::now() + std::chrono::seconds(5),
+                          boost::asio::bind_executor(
+                              strand, [&](boost::system::error_code const&) { reads(strand); }));
+    for (int i = 0; i < 2; ++i) {
+        out.async_write_frame(zmq::frame(std::string("x")), 0,
+                              boost::asio::bind_executor(
+                                  strand, [&](boost::system::error_code const&) {
+                                      writes(strand);
+                                  }));
+    }
+    out.connect(endpoint);
+    ios.run();
+    ios.restart();
+
+    in.async_read_frame(late, clock_type::now() + std::chrono::milliseconds(5),
+                        boost::asio::bind_executor(
+                            strand, [&](boost::system::error_code const&, bool) {
+                                reads(strand);
+                            }));
+    ios.run();
+
+    check(reads.all_on_strand(3), "read handlers run on their strand");
+    check(writes.all_on_strand(2), "write handlers run on their strand");
+}
+
+void foreign_io_service(zmq::context& ctx)
+{
+    boost::asio::io_service ios;
+    boost::asio::io_service other;
+    zmq::socket out(ios, ctx, ZMQ_PUSH);
+    out.bind("inproc://affinity.foreign");
+
+    //  The write waits for a peer while other runs on its own thread, which
+    //  may only return once the handler has run there.
+    std::thread::id ran_on;
+    out.async_write_frame(zmq::frame(16), 0,
+                          boost::asio::bind_executor(other.get_executor(),
+                                                     [&](boost::system::error_code const&) {
+                                                         ran_on = std::this_thread::get_id();
+                                                     }));
+    std::atomic<bool> done(false);
+    std::thread runner([&] {
+        other.run();
+        done = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    check(!done, "the handler's io_service keeps running while the write is queued");
+
+    zmq::socket in(ios, ctx, ZMQ_PULL);
+    in.connect("inproc://affinity.foreign");
+    ios.run();
+    std::thread::id runner_id = runner.get_id();
+    runner.join();
+    check(ran_on == runner_id, "the write handler runs on its own io_service");
+}
+
+}  // namespace
+
+int main()
+{
+    zmq::context ctx;
+    strand_handlers(ctx, zmq::completion_mode::post, "inproc://affinity.post");
+    strand_handlers(ctx, zmq::completion_mode::dispatch, "inproc://affinity.dispatch");
+    foreign_io_service(ctx);
+
+    if (failures != 0) return 1;
+    std::cout << "executor_affinity: ok" << std::endl;
+    return 0;
+}
+
+#else
+
+int main()
+{
+    std::cout << "executor_affinity: needs executors, skipped" << std::endl;
+    return 0;
+}
+
+#endif
@@ -0,0 +1,141 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <boost/asio.hpp>
+#include <asio-zmq.hpp>
+
+//  A proxy forwards single-part messages without building a message for
+//  them, and waits on the socket it writes to only while that socket holds a
+//  message back. Messages of both kinds must arrive whole and in order when
+//  the backend keeps filling up, and the capture socket and the statistics
+//  must see each of them once; timeouts turn a missed wakeup into a failure.
+
+namespace zmq = boost::asio::zmq;
+
+typedef std::chrono::steady_clock clock_type;
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, char const* what)
+{
+    if (!ok) {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failures;
+    }
+}
+
+int const message_count = 3000;
+
+//  Every third message has three parts.
+int parts_of(int i) { return i % 3 == 0 ? 3 : 1; }
+
+std::string text(zmq::frame const& frm)
+{
+    return std::string(static_cast<char const*>(frm.data()), frm.size());
+}
+
+}  // namespace
+
+int main()
+{
+    boost::asio::io_service ios;
+    zmq::context ctx;
+    zmq::socket frontend(ios, ctx, ZMQ_PULL);
+    zmq::socket backend(ios, ctx, ZMQ_PUSH);
+    zmq::socket capture(ios, ctx, ZMQ_PUSH);
+    zmq::socket producer(ios, ctx, ZMQ_PUSH);
+    zmq::socket consumer(ios, ctx, ZMQ_PULL);
+    zmq::socket tap(ios, ctx, ZMQ_PULL);
+
+    //  Small high-water marks make the backend refuse messages over and over.
+    backend.set_option(zmq::socket_option::send_buff_hwm(4));
+    consumer.set_option(zmq::socket_option::recv_buff_hwm(4));
+    capture.set_option(zmq::socket_option::send_buff_hwm(0));
+    tap.set_option(zmq::socket_option::recv_buff_hwm(0));
+    frontend.bind("inproc://proxy.in");
+    backend.bind("inproc://proxy.out");
+    capture.bind("inproc://proxy.capture");
+    producer.connect("inproc://proxy.in");
+    consumer.connect("inproc://proxy.out");
+    tap.connect("inproc://proxy.capture");
+
+    zmq::proxy proxy(frontend, backend, &capture);
+    bool completed = false;
+    proxy.async_run([&](boost::system::error_code const& ec) { completed = !ec; });
+    std::atomic<bool> stopped(false);
+    std::thread runner([&] {
+        ios.run();
+        stopped = true;
+    });
+
+    producer.set_option(zmq::socket_option::send_timeout(5000));
+    std::thread sender([&] {
+        try {
+            for (int i = 0; i < message_count; ++i) {
+                int parts = parts_of(i);
+                for (int p = 0; p < parts; ++p) {
+                    producer.write_frame(
+                        zmq::frame(std::to_string(i) + "." + std::to_string(p)),
+                        p + 1 < parts ? ZMQ_SNDMORE : 0);
+                }
+            }
+        }
+        catch (zmq::exception const&) {
+        }
+    });
+
+    //  The consumer starts late, so the proxy has a message held back first.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    consumer.set_option(zmq::socket_option::recv_timeout(5000));
+    bool in_order = true;
+    int received = 0;
+    try {
+        for (; received < message_count; ++received) {
+            zmq::message msg;
+            consumer.read_message(msg);
+            if (static_cast<int>(msg.size()) != parts_of(received)) in_order = false;
+            for (std::size_t p = 0; p < msg.size(); ++p) {
+                if (text(msg[p]) != std::to_string(received) + "." + std::to_string(p))
+                    in_order = false;
+            }
+        }
+    }
+    catch (zmq::exception const&) {
+    }
+    sender.join();
+    check(received == message_count, "every message is forwarded");
+    check(in_order, "messages arrive whole and in order");
+
+    int captured = 0;
+    tap.set_option(zmq::socket_option::recv_timeout(1000));
+    try {
+        for (; captured < message_count; ++captured) {
+            zmq::message msg;
+            tap.read_message(msg);
+        }
+    }
+    catch (zmq::exception const&) {
+    }
+    check(captured == message_count, "every message is captured once");
+
+    ios.post([&] { proxy.terminate(); });
+    clock_type::time_point give_up = clock_type::now() + std::chrono::seconds(5);
+    while (!stopped && clock_type::now() < give_up)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    if (!stopped) ios.stop();
+    runner.join();
+    check(completed, "the proxy completes after terminate");
+
+    zmq::proxy_statistics stats = proxy.statistics();
+    check(stats.frontend_messages_in == message_count, "messages in are counted");
+    check(stats.backend_messages_out == message_count, "messages out are counted");
+    check(stats.frontend_bytes_in == stats.backend_bytes_out, "bytes in and out agree");
+
+    if (failures != 0) return 1;
+    std::cout << "proxy_forwarding: ok" << std::endl;
+    return 0;
+}
@@ -0,0 +1,233 @@
+#include <chrono>
+#include <cstddef>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <boost/version.hpp>
+#include <boost/asio.hpp>
+#if BOOST_VERSION >= 107700
+#include <boost/asio/bind_cancellation_slot.hpp>
+#include <boost/asio/cancellation_signal.hpp>
+#endif
+#include <asio-zmq.hpp>
+
+//  Destroys sockets while operations are pending on them. Destroying a
+//  socket releases its descriptor, which wakes every pending wait with
+//  operation_aborted after the socket is gone; the operations must complete
+//  their handlers without touching it. Build with -fsanitize=address to catch
+//  any access to the destroyed socket.
+
+namespace zmq = boost::asio::zmq;
+
+typedef std::chrono::steady_clock clock_type;
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, char const* what)
+{
+    if (!ok) {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failures;
+    }
+}
+
+struct outcome {
+    int calls;
+    boost::system::error_code ec;
+
+    outcome() : calls(0), ec() {}
+
+    void operator()(boost::system::error_code const& e)
+    {
+        ++calls;
+        ec = e;
+    }
+
+    bool aborted_once() const
+    {
+        return calls == 1 && ec == boost::asio::error::operation_aborted;
+    }
+};
+
+void pending_reads(zmq::context& ctx)
+{
+    boost::asio::io_service ios;
+    std::unique_ptr<zmq::socket> sock(new zmq::socket(ios, ctx, ZMQ_PULL));
+    sock->bind("inproc://teardown.reads");
+
+    zmq::message msg;
+    zmq::frame frm;
+    std::vector<zmq::message> batch;
+    outcome message_result, frame_result, batch_result;
+    sock->async_read_message(msg, [&](boost::system::error_code const& ec) {
+        message_result(ec);
+    });
+    sock->async_read_frame(frm, [&](boost::system::error_code const& ec, bool) {
+        frame_result(ec);
+    });
+    sock->async_read_messages(batch, 8, [&](boost::system::error_code const& ec, std::size_t) {
+        batch_result(ec);
+    });
+
+    sock.reset();
+    ios.run();
+    check(message_result.aborted_once(), "async_read_message is aborted");
+    check(frame_result.aborted_once(), "async_read_frame is aborted");
+    check(batch_result.aborted_once(), "async_read_messages is aborted");
+}
+
+void pending_deadline_reads(zmq::context& ctx)
+{
+    boost::asio::io_service ios;
+    std::unique_ptr<zmq::socket> sock(new zmq::socket(ios, ctx, ZMQ_PULL));
+    sock->bind("inproc://teardown.deadlines");
+
+    //  The first read times out and goes stale while the second keeps waiting;
+    //  the third still has its deadline ahead when the socket goes away.
+    zmq::frame stale, waiting, pending;
+    outcome stale_result, waiting_result, pending_result;
+    sock->async_read_frame(stale, clock_type::now() + std::chrono::milliseconds(5),
+                           [&](boost::system::error_code const& ec, bool) { stale_result(ec); });
+    sock->async_read_frame(waiting,
+                           [&](boost::system::error_code const& ec, bool) { waiting_result(ec); });
+    while (stale_result.calls == 0) ios.run_one();
+    sock->async_read_frame(pending, clock_type::now() + std::chrono::milliseconds(50),
+                           [&](boost::system::error_code const& ec, bool) { pending_result(ec); });
+
+    sock.reset();
+    ios.run();
+    check(stale_result.calls == 1 && stale_result.ec == boost::asio::error::timed_out,
+          "a stale read completes once, with timed_out");
+    check(waiting_result.aborted_once(), "a read without a deadline is aborted");
+    check(pending_result.aborted_once(), "a read before its deadline is aborted");
+
+    //  Nothing may fire when the abandoned deadline would have passed.
+    boost::asio::steady_timer timer(ios, std::chrono::milliseconds(60));
+    timer.async_wait([](boost::system::error_code const&) {});
+    ios.restart();
+    ios.run();
+    check(pending_result.calls == 1, "a read is not completed again at its deadline");
+}
+
+#if BOOST_VERSION >= 107700
+void cancelled_after_teardown(zmq::context& ctx)
+{
+    boost::asio::io_service ios;
+    std::unique_ptr<zmq::socket> sock(new zmq::socket(ios, ctx, ZMQ_PULL));
+    sock->bind("inproc://teardown.cancel");
+
+    //  The signal arrives between the socket going away and the aborted read
+    //  running, and must leave the completion to the read.
+    zmq::frame frm;
+    boost::asio::cancellation_signal signal;
+    outcome result;
+    sock->async_read_frame(
+        frm, boost::asio::bind_cancellation_slot(
+                 signal.slot(), [&](boost::system::error_code const& ec, bool) { result(ec); }));
+
+    sock.reset();
+    signal.emit(boost::asio::cancellation_type::terminal);
+    ios.run();
+    check(result.aborted_once(), "a read cancelled after teardown is aborted once");
+}
+#endif
+
+void blocked_writes(zmq::context& ctx)
+{
+    boost::asio::io_service ios;
+    std::unique_ptr<zmq::socket> sock(new zmq::socket(ios, ctx, ZMQ_PUSH));
+    sock->bind("inproc://teardown.writes");
+
+    //  Without a peer a PUSH socket takes nothing, so the first write waits for
+    //  the descriptor on behalf of the whole queue.
+    outcome results[3];
+    for (int i = 0; i < 3; ++i) {
+        outcome* result = &results[i];
+        sock->async_write_frame(zmq::frame(16), 0,
+                                [result](boost::system::error_code const& ec) { (*result)(ec); });
+    }
+    std::future<void> future = sock->async_write_frame(zmq::frame(16), 0, boost::asio::use_future);
+
+    sock.reset();
+    check(results[0].calls == 0, "queued writes are not completed inside the destructor");
+    ios.run();
+    bool aborted = true;
+    for (auto const& result : results) aborted = aborted && result.aborted_once();
+    check(aborted, "queued writes are aborted");
+    try {
+        future.get();
+        check(false, "a queued write's future is aborted");
+    }
+    catch (boost::system::system_error const& e) {
+        check(e.code() == boost::asio::error::operation_aborted,
+              "a queued write's future is aborted");
+    }
+    catch (std::exception const&) {
+        check(false, "a queued write's future is aborted");
+    }
+}
+
+void destroyed_by_write_handler(zmq::context& ctx)
+{
+    boost::asio::io_service ios;
+    std::unique_ptr<zmq::socket> sock(new zmq::socket(ios, ctx, ZMQ_PUSH));
+    sock->set_completion_mode(zmq::completion_mode::dispatch);
+    sock->bind("inproc://teardown.flush");
+
+    //  The writes queue up until a peer connects. The first one's handler then
+    //  runs inline from the flush of the queue and destroys the socket under it,
+    //  which aborts the other two.
+    int sent = 0;
+    int aborted = 0;
+    for (int i = 0; i < 3; ++i) {
+        sock->async_write_frame(zmq::frame(16), 0, [&](boost::system::error_code const& ec) {
+            if (!ec) ++sent;
+            if (ec == boost::asio::error::operation_aborted) ++aborted;
+            sock.reset();
+        });
+    }
+    zmq::socket peer(ios, ctx, ZMQ_PULL);
+    peer.connect("inproc://teardown.flush");
+
+    ios.run();
+    check(sent == 1, "a write handler may destroy its socket");
+    check(aborted == 2, "the writes queued behind it are aborted");
+}
+
+void pending_monitor(zmq::context& ctx)
+{
+    boost::asio::io_service ios;
+    std::unique_ptr<zmq::socket> sock(new zmq::socket(ios, ctx, ZMQ_PULL));
+
+    outcome result;
+    sock->async_monitor(ZMQ_EVENT_ALL,
+                        [&](boost::system::error_code const& ec, zmq::monitor_event const&) {
+                            result(ec);
+                        });
+
+    sock.reset();
+    ios.run();
+    check(result.aborted_once(), "async_monitor is aborted");
+}
+
+}  // namespace
+
+int main()
+{
+    zmq::context ctx;
+    pending_reads(ctx);
+    pending_deadline_reads(ctx);
+#if BOOST_VERSION >= 107700
+    cancelled_after_teardown(ctx);
+#endif
+    blocked_writes(ctx);
+    destroyed_by_write_handler(ctx);
+    pending_monitor(ctx);
+
+    if (failures != 0) return 1;
+    std::cout << "socket_teardown: ok" << std::endl;
+    return 0;
+}
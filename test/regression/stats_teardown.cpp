@@ -0,0 +1,45 @@
+#define ASIO_ZMQ_ENABLE_STATS 1
+
+#include <iostream>
+#include <memory>
+#include <boost/asio.hpp>
+#include <asio-zmq.hpp>
+
+//  Destroys a socket whose completion is queued on the io_service but has not
+//  run. With instrumentation enabled the completion times how long it waited
+//  and must drop that sample rather than write to the destroyed socket's
+//  counters. Build with -fsanitize=address to catch the write.
+
+namespace zmq = boost::asio::zmq;
+
+int main()
+{
+    zmq::context ctx;
+    boost::asio::io_service ios;
+
+    zmq::socket pusher(ios, ctx, ZMQ_PUSH);
+    std::unique_ptr<zmq::socket> puller(new zmq::socket(ios, ctx, ZMQ_PULL));
+    puller->bind("inproc://teardown.stats");
+    pusher.connect("inproc://teardown.stats");
+    pusher.write_frame(zmq::frame(16));
+
+    //  The message is already there, so the read finishes at once and only
+    //  its handler is left on the queue.
+    zmq::message msg;
+    int calls = 0;
+    boost::system::error_code result;
+    puller->async_read_message(msg, [&](boost::system::error_code const& ec) {
+        ++calls;
+        result = ec;
+    });
+
+    puller.reset();
+    ios.run();
+    if (calls != 1 || result || msg.size() != 1) {
+        std::cerr << "FAILED: a completed read is delivered after its socket is destroyed"
+                  << std::endl;
+        return 1;
+    }
+    std::cout << "stats_teardown: ok" << std::endl;
+    return 0;
+}
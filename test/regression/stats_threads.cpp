@@ -0,0 +1,98 @@
+#define ASIO_ZMQ_ENABLE_STATS 1
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <boost/version.hpp>
+#include <boost/asio.hpp>
+#include <asio-zmq.hpp>
+
+//  Handlers record how long they waited into their socket's histograms when
+//  they start, on their associated executors. The handlers of one socket are
+//  bound here to io_services run by different threads, so on a multi-core
+//  machine they record at the same time: every sample must still be counted.
+
+namespace zmq = boost::asio::zmq;
+
+#if BOOST_VERSION >= 106600
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, char const* what)
+{
+    if (!ok) {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failures;
+    }
+}
+
+int const thread_count = 4;
+int const write_count = 20000;
+
+}  // namespace
+
+int main()
+{
+    zmq::context ctx;
+    boost::asio::io_service ios;
+    zmq::socket out(ios, ctx, ZMQ_PUSH);
+    zmq::socket in(ios, ctx, ZMQ_PULL);
+    //  With no high-water marks the writes seldom wait for room.
+    out.set_option(zmq::socket_option::send_buff_hwm(0));
+    in.set_option(zmq::socket_option::recv_buff_hwm(0));
+    in.bind("inproc://stats.threads");
+    out.connect("inproc://stats.threads");
+
+    std::vector<std::unique_ptr<boost::asio::io_service>> others;
+    std::vector<std::unique_ptr<boost::asio::io_service::work>> works;
+    std::vector<std::thread> runners;
+    for (int i = 0; i < thread_count; ++i) {
+        others.emplace_back(new boost::asio::io_service);
+        works.emplace_back(new boost::asio::io_service::work(*others.back()));
+    }
+    for (int i = 0; i < thread_count; ++i) {
+        boost::asio::io_service& other = *others[i];
+        runners.emplace_back([&other] { other.run(); });
+    }
+
+    std::atomic<int> completed(0);
+    for (int i = 0; i < write_count; ++i) {
+        out.async_write_frame(zmq::frame(8), 0,
+                              boost::asio::bind_executor(others[i % thread_count]->get_executor(),
+                                                         [&](boost::system::error_code const&) {
+                                                             completed.fetch_add(1);
+                                                         }));
+    }
+    while (completed != write_count) ios.poll();
+    works.clear();
+    for (auto& t : runners) t.join();
+
+    zmq::socket_stats stats = out.stats();
+    check(completed == write_count, "every write completes");
+    check(stats.queue_delay.count() == static_cast<std::uint64_t>(write_count),
+          "every handler's queue delay is recorded");
+    check(stats.queue_delay.min() <= stats.queue_delay.max(), "the minimum is at most the maximum");
+
+    std::uint64_t bucketed = 0;
+    for (std::size_t i = 0; i < zmq::histogram::bucket_count; ++i)
+        bucketed += stats.queue_delay.bucket(i);
+    check(bucketed == stats.queue_delay.count(), "every sample lands in a bucket");
+
+    if (failures != 0) return 1;
+    std::cout << "stats_threads: ok" << std::endl;
+    return 0;
+}
+
+#else
+
+int main()
+{
+    std::cout << "stats_threads: needs executors, skipped" << std::endl;
+    return 0;
+}
+
+#endif
@@ -0,0 +1,204 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include <asio-zmq.hpp>
+
+//  A write queue that cannot send waits for ZMQ_FD to signal, which happens
+//  only for changes made by ZeroMQ's I/O threads and the socket's peers. These
+//  cases would leave the queue, or the io_service, waiting for a signal that
+//  never comes; a watchdog turns such a hang into a failure.
+
+namespace zmq = boost::asio::zmq;
+
+typedef std::chrono::steady_clock clock_type;
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, char const* what)
+{
+    if (!ok) {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failures;
+    }
+}
+
+//  Runs ios until it is out of work; false if it was still busy after a few
+//  seconds.
+bool run_briefly(boost::asio::io_service& ios)
+{
+    std::atomic<bool> done(false);
+    std::thread runner([&] {
+        ios.run();
+        done = true;
+    });
+    clock_type::time_point give_up = clock_type::now() + std::chrono::seconds(5);
+    while (!done && clock_type::now() < give_up)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    bool finished = done;
+    ios.stop();
+    runner.join();
+    ios.restart();
+    return finished;
+}
+
+std::string text(zmq::frame const& frm)
+{
+    return std::string(static_cast<char const*>(frm.data()), frm.size());
+}
+
+void connect_after_write(zmq::context& ctx)
+{
+    boost::asio::io_service ios;
+    zmq::socket out(ios, ctx, ZMQ_PUSH);
+    zmq::socket in(ios, ctx, ZMQ_PULL);
+    in.bind("inproc://waits.connect");
+
+    //  An inproc connect attaches its pipe at once, without signalling ZMQ_FD.
+    int written = 0;
+    for (int i = 0; i < 3; ++i) {
+        out.async_write_frame(zmq::frame(std::string(1, char('a' + i))), 0,
+                              [&](boost::system::error_code const& ec) {
+                                  if (!ec) ++written;
+                              });
+    }
+    out.connect("inproc://waits.connect");
+
+    check(run_briefly(ios), "writes queued before an inproc connect do not hang");
+    check(written == 3, "writes queued before an inproc connect are sent");
+    check(text(in.read_frame()) == "a", "queued writes keep their order");
+}
+
+void writes_time_out(zmq::context& ctx)
+{
+    boost::asio::io_service ios;
+    zmq::socket lonely(ios, ctx, ZMQ_PUSH);
+
+    int timed_out = 0;
+    for (int i = 0; i < 2; ++i) {
+        lonely.async_write_frame(zmq::frame(16), 0,
+                                 clock_type::now() + std::chrono::milliseconds(5 * (i + 1)),
+                                 [&](boost::system::error_code const& ec) {
+                                     if (ec == boost::asio::error::timed_out) ++timed_out;
+                                 });
+    }
+
+    check(run_briefly(ios), "the io_service runs out of work once every write timed out");
+    check(timed_out == 2, "writes without a peer time out");
+}
+
+void write_after_timeout(zmq::context& ctx)
+{
+    boost::asio::io_service ios;
+    zmq::socket dealer(ios, ctx, ZMQ_DEALER);
+
+    //  A read keeps waiting on the descriptor while the first write times out,
+    //  so the wait armed for that write stays behind it. Writes and the read
+    //  must carry on regardless.
+    zmq::frame reply;
+    bool replied = false;
+    dealer.async_read_frame(reply, [&](boost::system::error_code const& ec, bool) {
+        replied = !ec;
+    });
+    bool timed_out = false;
+    dealer.async_write_frame(zmq::frame(std::string("lost")), 0,
+                             clock_type::now() + std::chrono::milliseconds(5),
+                             [&](boost::system::error_code const& ec) {
+                                 timed_out = ec == boost::asio::error::timed_out;
+                             });
+    while (!timed_out) ios.run_one();
+
+    zmq::socket router(ios, ctx, ZMQ_ROUTER);
+    router.bind("inproc://waits.dealer");
+    dealer.connect("inproc://waits.dealer");
+    bool written = false;
+    dealer.async_write_frame(zmq::frame(std::string("ping")), 0,
+                             [&](boost::system::error_code const& ec) { written = !ec; });
+    ios.poll();
+    ios.restart();
+    check(written, "a write after one timed out is sent at once");
+
+    zmq::frame id = router.read_frame();
+    zmq::frame body = router.read_frame();
+    check(text(body) == "ping", "the write after a timeout is delivered");
+    router.write_frame(id, ZMQ_SNDMORE);
+    router.write_frame(zmq::frame(std::string("pong")));
+    check(run_briefly(ios), "the read completes");
+    check(replied && text(reply) == "pong", "the read receives the reply");
+}
+
+void blocked_peer(zmq::context& ctx)
+{
+    boost::asio::io_service ios;
+    zmq::socket router(ios, ctx, ZMQ_ROUTER);
+    router.set_option(zmq::socket_option::router_mandatory(true));
+    router.set_option(zmq::socket_option::send_buff_hwm(1));
+    router.bind("inproc://waits.router");
+    zmq::socket stuck(ios, ctx, ZMQ_DEALER);
+    zmq::socket idle(ios, ctx, ZMQ_DEALER);
+    for (zmq::socket* peer : {&stuck, &idle})
+        peer->set_option(zmq::socket_option::recv_buff_hwm(1));
+    stuck.set_option(zmq::socket_option::identity("stuck"));
+    idle.set_option(zmq::socket_option::identity("idle"));
+    stuck.connect("inproc://waits.router");
+    idle.connect("inproc://waits.router");
+
+    //  Once the pipe to the peer that never reads is full, sends to it fail
+    //  while ZMQ_EVENTS still reports room for the other peer. The queue must
+    //  wait rather than retry for as long as that lasts, which would never
+    //  return from the call that queued the write; a watchdog ends the test
+    //  if it does not.
+    std::atomic<bool> returned(false);
+    std::thread watchdog([&] {
+        clock_type::time_point give_up = clock_type::now() + std::chrono::seconds(5);
+        while (!returned && clock_type::now() < give_up)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (!returned) {
+            std::cerr << "FAILED: a write to a full peer does not spin" << std::endl;
+            std::_Exit(1);
+        }
+    });
+    int written = 0;
+    std::vector<zmq::message> msgs(8);
+    for (auto& msg : msgs) {
+        msg.push_back(zmq::frame(std::string("stuck")));
+        msg.push_back(zmq::frame(16));
+        router.async_write_message(msg, [&](boost::system::error_code const& ec) {
+            if (!ec) ++written;
+        });
+    }
+    ios.poll();
+    ios.restart();
+    returned = true;
+    watchdog.join();
+    check(written > 0 && written < 8, "writes to a full peer wait for room");
+
+    //  Reading makes room, which signals ZMQ_FD and resumes the queue.
+    for (int i = 0; i < 8; ++i) {
+        stuck.read_frame();
+        ios.poll();
+        ios.restart();
+    }
+    check(written == 8, "writes to a full peer resume once it reads");
+}
+
+}  // namespace
+
+int main()
+{
+    zmq::context ctx;
+    connect_after_write(ctx);
+    writes_time_out(ctx);
+    write_after_timeout(ctx);
+    blocked_peer(ctx);
+
+    if (failures != 0) return 1;
+    std::cout << "write_waits: ok" << std::endl;
+    return 0;
+}